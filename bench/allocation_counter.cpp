@@ -0,0 +1,77 @@
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#include "allocation_counter.h"
+
+namespace {
+    std::atomic<std::size_t> counter{0};
+
+    void *counted_alloc(std::size_t size, std::size_t alignment) {
+        counter.fetch_add(1, std::memory_order_relaxed);
+        void *ptr = alignment <= alignof(std::max_align_t)
+                    ? std::malloc(size ? size : 1)
+                    : std::aligned_alloc(alignment, (size + alignment - 1) / alignment * alignment);
+        if (!ptr) {
+            throw std::bad_alloc();
+        }
+        return ptr;
+    }
+}  // namespace
+
+std::size_t bench::allocations() noexcept {
+    return counter.load(std::memory_order_relaxed);
+}
+
+void bench::report_allocations(benchmark::State &state, std::size_t before) {
+    state.counters["allocs"] = benchmark::Counter(static_cast<double>(allocations() - before),
+                                                  benchmark::Counter::kAvgIterations);
+}
+
+void *operator new(std::size_t size) {
+    return counted_alloc(size, alignof(std::max_align_t));
+}
+
+void *operator new[](std::size_t size) {
+    return counted_alloc(size, alignof(std::max_align_t));
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment) {
+    return counted_alloc(size, static_cast<std::size_t>(alignment));
+}
+
+void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
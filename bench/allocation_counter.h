@@ -0,0 +1,16 @@
+#ifndef MP_CPP_HW1_ALLOCATION_COUNTER
+#define MP_CPP_HW1_ALLOCATION_COUNTER
+
+#include <cstddef>  // std::size_t
+
+#include "benchmark/benchmark.h"
+
+namespace bench {
+    // Number of calls to the global operator new made by the whole program so far
+    std::size_t allocations() noexcept;
+
+    // Reports the heap allocations made per iteration of the benchmark loop since `before`
+    void report_allocations(benchmark::State &state, std::size_t before);
+}  // namespace bench
+
+#endif  // MP_CPP_HW1_ALLOCATION_COUNTER
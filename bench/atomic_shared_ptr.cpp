@@ -0,0 +1,115 @@
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "atomic_shared_ptr.h"
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "shared_ptr.h"
+
+namespace {
+    struct Config {
+        int version = 0;
+        int routes[15] = {};
+    };
+
+    // The baseline: a shared_ptr behind a mutex
+    class MutexCell {
+    public:
+        using pointer = smart_pointer::shared_ptr<Config>;
+
+        pointer load() {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return value_;
+        }
+
+        void store(pointer desired) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::swap(value_, desired);
+            }
+            // The old value is destroyed outside of the lock
+        }
+
+    private:
+        std::mutex mutex_;
+        pointer value_;
+    };
+
+    class AtomicCell {
+    public:
+        using pointer = smart_pointer::shared_ptr<Config>;
+
+        pointer load() {
+            return value_.load();
+        }
+
+        void store(pointer desired) {
+            value_.store(std::move(desired));
+        }
+
+    private:
+        smart_pointer::atomic_shared_ptr<Config> value_;
+    };
+
+    class StdAtomicCell {
+    public:
+        using pointer = std::shared_ptr<Config>;
+
+        pointer load() {
+            return value_.load();
+        }
+
+        void store(pointer desired) {
+            value_.store(std::move(desired));
+        }
+
+    private:
+        std::atomic<std::shared_ptr<Config>> value_;
+    };
+
+    // Every thread loads the current snapshot; thread 0 also publishes a new one every `period` iterations
+    // (never if period is 0)
+    template<typename Cell>
+    void read_mostly(benchmark::State &state) {
+        static Cell cell;
+        auto period = state.range(0);
+        if (state.thread_index() == 0) {
+            cell.store(fixtures::make<typename Cell::pointer>(Config{0}));
+        }
+        std::int64_t iteration = 0;
+        for (auto _: state) {
+            if (state.thread_index() == 0 && period && ++iteration % period == 0) {
+                cell.store(fixtures::make<typename Cell::pointer>(Config{static_cast<int>(iteration)}));
+            }
+            auto snapshot = cell.load();
+            benchmark::DoNotOptimize(snapshot->version);
+        }
+        if (state.thread_index() == 0) {
+            cell.store(typename Cell::pointer());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_Mutex(benchmark::State &state) {
+        read_mostly<MutexCell>(state);
+    }
+
+    void BM_Atomic(benchmark::State &state) {
+        read_mostly<AtomicCell>(state);
+    }
+
+    void BM_StdAtomic(benchmark::State &state) {
+        read_mostly<StdAtomicCell>(state);
+    }
+
+    const int cores = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+}  // namespace
+
+// Period 0: readers only; 100: one store per hundred loads of thread 0
+BENCHMARK(BM_Mutex)->Arg(0)->Arg(100)->ThreadRange(1, cores)->UseRealTime();
+BENCHMARK(BM_Atomic)->Arg(0)->Arg(100)->ThreadRange(1, cores)->UseRealTime();
+BENCHMARK(BM_StdAtomic)->Arg(0)->Arg(100)->ThreadRange(1, cores)->UseRealTime();
@@ -0,0 +1,75 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "memory_usage.h"
+#include "shared_ptr.h"
+
+// A bulk load of state.range(0) small objects with the same lifetime into a vector of handles, made in one batch by
+// make_shared_batch or one by one by make_shared. BM_Load times the load and reports the memory it added to the
+// peak resident set size per object, BM_Iterate reads a field of every object through its handle
+
+namespace {
+    using fixtures::Dog;
+
+    template<bool Batch>
+    std::vector<smart_pointer::shared_ptr<Dog>> load(std::size_t count) {
+        if constexpr (Batch) {
+            return smart_pointer::make_shared_batch<Dog>(count);
+        } else {
+            std::vector<smart_pointer::shared_ptr<Dog>> zoo;
+            zoo.reserve(count);
+            for (std::size_t i = 0; i < count; ++i) {
+                zoo.push_back(smart_pointer::make_shared<Dog>());
+            }
+            return zoo;
+        }
+    }
+
+    template<bool Batch>
+    void BM_Load(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0));
+        bench::reset_peak_rss();
+        std::size_t before_rss = bench::peak_rss();
+        std::size_t before = bench::allocations();
+        std::size_t bytes = 0;
+        for (auto _: state) {
+            auto zoo = load<Batch>(count);
+            benchmark::DoNotOptimize(zoo.data());
+            state.PauseTiming();
+            bytes = std::max(bytes, bench::peak_rss() - before_rss);
+            zoo = {};
+            state.ResumeTiming();
+        }
+        bench::report_allocations(state, before);
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+        state.counters["bytes_per_object"] = static_cast<double>(bytes) / static_cast<double>(count);
+    }
+
+    template<bool Batch>
+    void BM_Iterate(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0));
+        auto zoo = load<Batch>(count);
+        for (auto _: state) {
+            std::int64_t ages = 0;
+            for (const auto &dog: zoo) {
+                ages += dog->age;
+            }
+            benchmark::DoNotOptimize(ages);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+    }
+}  // namespace
+
+// A fixed number of iterations runs each load benchmark only once. Freed memory stays resident, so only the first
+// load of a run shows up in the peak: run the loads one at a time with --benchmark_filter for their memory figures
+constexpr int objects = 1'000'000;
+
+BENCHMARK_TEMPLATE(BM_Load, true)->Arg(objects)->Iterations(10)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Load, false)->Arg(objects)->Iterations(10)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Iterate, true)->Arg(objects)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Iterate, false)->Arg(objects)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,61 @@
+#include <cstddef>
+#include <mutex>
+#include <utility>
+
+#include "benchmark/benchmark.h"
+#include "biased_count.h"
+#include "shared_ptr.h"
+
+// biased_count against atomic_count on two workloads: pointers copied almost only by the thread that created them,
+// where biased counting avoids the atomic instructions, and one pointer copied by every thread, where all but the
+// owner pay for the atomic counter plus the check for ownership
+
+namespace {
+    template<typename Policy>
+    using Ptr = smart_pointer::shared_ptr<int, Policy>;
+
+    // Every thread makes its own pointer and copies it; one copy in 1000 is swapped with whatever another thread
+    // left in a mailbox, which is released here
+    template<typename Policy>
+    void BM_MostlyLocal(benchmark::State &state) {
+        static std::mutex mailbox_mutex;
+        static Ptr<Policy> mailbox;
+        auto own = smart_pointer::make_shared<int, Policy>(state.thread_index());
+        std::size_t i = 0;
+        for (auto _: state) {
+            Ptr<Policy> copy(own);
+            benchmark::DoNotOptimize(copy.get());
+            if (++i % 1000 == 0) {
+                std::lock_guard<std::mutex> lock(mailbox_mutex);
+                std::swap(copy, mailbox);
+            }
+        }
+        if (state.thread_index() == 0) {
+            std::lock_guard<std::mutex> lock(mailbox_mutex);
+            mailbox = Ptr<Policy>();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Every thread copies one pointer made by thread 0
+    template<typename Policy>
+    void BM_FullyShared(benchmark::State &state) {
+        static Ptr<Policy> shared;
+        if (state.thread_index() == 0) {
+            shared = smart_pointer::make_shared<int, Policy>(0);
+        }
+        for (auto _: state) {
+            Ptr<Policy> copy(shared);
+            benchmark::DoNotOptimize(copy.get());
+        }
+        if (state.thread_index() == 0) {
+            shared = Ptr<Policy>();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_MostlyLocal, smart_pointer::atomic_count)->ThreadRange(1, 4);
+BENCHMARK_TEMPLATE(BM_MostlyLocal, smart_pointer::biased_count)->ThreadRange(1, 4);
+BENCHMARK_TEMPLATE(BM_FullyShared, smart_pointer::atomic_count)->ThreadRange(1, 4);
+BENCHMARK_TEMPLATE(BM_FullyShared, smart_pointer::biased_count)->ThreadRange(1, 4);
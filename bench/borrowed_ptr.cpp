@@ -0,0 +1,39 @@
+#include <cstdint>
+
+#include "benchmark/benchmark.h"
+#include "borrowed_ptr.h"
+#include "shared_ptr.h"
+
+// A request handled by a chain of state.range(0) nested calls, each passing the object on to the next and the last
+// reading it. Passing the shared_ptr by value costs an increment and a decrement of the count per call, a
+// borrowed_ptr costs nothing more than the const reference it is compared with. Items are calls
+
+namespace {
+    struct Request {
+        std::int64_t id = 42;
+    };
+
+    template<typename Handle>
+    [[gnu::noinline]] std::int64_t handle(Handle request, std::int64_t depth) {
+        if (depth == 0) {
+            return request->id;
+        }
+        // Keeps the compiler from turning the recursion into a loop
+        std::int64_t id = handle<Handle>(request, depth - 1);
+        benchmark::DoNotOptimize(id);
+        return id;
+    }
+
+    template<typename Handle>
+    void BM_CallChain(benchmark::State &state) {
+        auto request = smart_pointer::make_shared<Request>();
+        for (auto _: state) {
+            benchmark::DoNotOptimize(handle<Handle>(request, state.range(0)));
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_CallChain, smart_pointer::borrowed_ptr<Request>)->Arg(64);
+BENCHMARK_TEMPLATE(BM_CallChain, smart_pointer::shared_ptr<Request>)->Arg(64);
+BENCHMARK_TEMPLATE(BM_CallChain, const smart_pointer::shared_ptr<Request> &)->Arg(64);
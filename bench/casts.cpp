@@ -0,0 +1,56 @@
+#include <algorithm>
+#include <memory>
+
+#include "allocation_counter.h"
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "shared_ptr.h"
+
+namespace {
+    using fixtures::Animal;
+    using fixtures::Dog;
+
+    // Slicing a shared buffer into views: the aliasing constructor only bumps the count of the buffer
+    void BM_AliasingView(benchmark::State &state) {
+        auto buffer = smart_pointer::make_shared<char[]>(1 << 20);
+        auto before = bench::allocations();
+        for (auto _: state) {
+            smart_pointer::shared_ptr<char[]> view(buffer, buffer.get() + state.range(0));
+            benchmark::DoNotOptimize(view.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // The alternative without aliasing: copy the slice into a buffer of its own
+    void BM_CopiedSlice(benchmark::State &state) {
+        auto buffer = smart_pointer::make_shared<char[]>(1 << 20);
+        auto before = bench::allocations();
+        for (auto _: state) {
+            auto slice = smart_pointer::make_shared<char[]>(state.range(0));
+            std::copy_n(buffer.get(), state.range(0), slice.get());
+            benchmark::DoNotOptimize(slice.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    void BM_DynamicCast(benchmark::State &state) {
+        smart_pointer::shared_ptr<Animal> animal = smart_pointer::make_shared<Dog>();
+        for (auto _: state) {
+            auto dog = smart_pointer::dynamic_pointer_cast<Dog>(animal);
+            benchmark::DoNotOptimize(dog.get());
+        }
+    }
+
+    void BM_StdDynamicCast(benchmark::State &state) {
+        std::shared_ptr<Animal> animal = std::make_shared<Dog>();
+        for (auto _: state) {
+            auto dog = std::dynamic_pointer_cast<Dog>(animal);
+            benchmark::DoNotOptimize(dog.get());
+        }
+    }
+}  // namespace
+
+BENCHMARK(BM_AliasingView)->Arg(4096)->Arg(1 << 16);
+BENCHMARK(BM_CopiedSlice)->Arg(4096)->Arg(1 << 16);
+BENCHMARK(BM_DynamicCast);
+BENCHMARK(BM_StdDynamicCast);
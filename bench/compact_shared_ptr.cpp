@@ -0,0 +1,53 @@
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "compact_shared_ptr.h"
+#include "fixtures.h"
+#include "memory_usage.h"
+#include "shared_ptr.h"
+
+// An array of 50M handles to a million animals, scanned from start to end reading a field of every animal. Reports
+// the memory the array added to the peak resident set size per handle, and the handles scanned per second
+
+namespace {
+    using fixtures::Animal;
+
+    constexpr std::size_t animals = 1'000'000;
+
+    template<typename Handle>
+    void BM_Scan(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0));
+        std::vector<Handle> zoo;
+        for (std::size_t i = 0; i < animals; ++i) {
+            zoo.emplace_back(smart_pointer::make_shared<Animal>());
+        }
+        bench::reset_peak_rss();
+        std::size_t before = bench::peak_rss();
+        zoo.reserve(count);
+        for (std::size_t i = animals; i < count; ++i) {
+            zoo.push_back(zoo[i % animals]);
+        }
+        std::size_t after = bench::peak_rss();
+
+        for (auto _: state) {
+            std::int64_t ages = 0;
+            for (const Handle &animal: zoo) {
+                ages += animal->age;
+            }
+            benchmark::DoNotOptimize(ages);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+        state.counters["bytes_per_handle"] = static_cast<double>(after - before) / static_cast<double>(count - animals);
+    }
+}  // namespace
+
+// A fixed number of iterations builds the array only once. Freed memory stays resident, so the second benchmark may
+// reuse what the first left: run one at a time with --benchmark_filter for isolated figures
+constexpr int handles = 50'000'000;
+
+BENCHMARK_TEMPLATE(BM_Scan, smart_pointer::compact_shared_ptr<Animal>)
+        ->Arg(handles)->Iterations(5)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_Scan, smart_pointer::shared_ptr<Animal>)
+        ->Arg(handles)->Iterations(5)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,104 @@
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "deferred_count.h"
+#include "shared_ptr.h"
+
+// Latency of "requests" on a thread that now and then drops the last reference to a big object graph. With
+// atomic_count the request that drops it pays for the whole destructor cascade; with deferred_count the graph is
+// destroyed later by drain() between requests, or by a reclaimer_thread. Reports the 50th, 99th and 99.9th
+// percentile of the request latency in nanoseconds
+
+namespace {
+    constexpr std::size_t requests = 20000;
+    // Every this many requests one graph is dropped
+    constexpr std::size_t drop_period = 100;
+    constexpr std::size_t children = 100;
+    constexpr std::size_t grandchildren = 100;
+
+    template<typename Policy>
+    struct Node {
+        std::vector<smart_pointer::shared_ptr<Node, Policy>> children;
+        std::int64_t payload[4] = {};
+    };
+
+    // A tree of 1 + children + children * grandchildren nodes
+    template<typename Policy>
+    smart_pointer::shared_ptr<Node<Policy>, Policy> make_graph() {
+        auto root = smart_pointer::make_shared<Node<Policy>, Policy>();
+        for (std::size_t i = 0; i < children; ++i) {
+            auto child = smart_pointer::make_shared<Node<Policy>, Policy>();
+            for (std::size_t j = 0; j < grandchildren; ++j) {
+                child->children.push_back(smart_pointer::make_shared<Node<Policy>, Policy>());
+            }
+            root->children.push_back(std::move(child));
+        }
+        return root;
+    }
+
+    // The work of a request that does not drop anything
+    std::int64_t work(std::size_t request) {
+        std::int64_t sum = 0;
+        for (std::size_t i = 0; i < 2000; ++i) {
+            sum += static_cast<std::int64_t>((request * 31 + i) % 7);
+        }
+        return sum;
+    }
+
+    enum class Reclaim {
+        Immediately,
+        DrainBetweenRequests,
+        BackgroundThread
+    };
+
+    template<typename Policy, Reclaim how>
+    void BM_RequestLatency(benchmark::State &state) {
+        std::vector<double> latencies;
+        latencies.reserve(requests);
+        for (auto _: state) {
+            state.PauseTiming();
+            std::vector<smart_pointer::shared_ptr<Node<Policy>, Policy>> graphs;
+            for (std::size_t i = 0; i < requests / drop_period; ++i) {
+                graphs.push_back(make_graph<Policy>());
+            }
+            latencies.clear();
+            state.ResumeTiming();
+            {
+                // Reclaims in the background while the requests run, if asked to; otherwise a placeholder
+                [[maybe_unused]] std::conditional_t<how == Reclaim::BackgroundThread, smart_pointer::reclaimer_thread,
+                                                    int> reclaimer{};
+                for (std::size_t request = 0; request < requests; ++request) {
+                    auto start = std::chrono::steady_clock::now();
+                    benchmark::DoNotOptimize(work(request));
+                    if (request % drop_period == 0) {
+                        graphs[request / drop_period].reset();
+                    }
+                    auto finish = std::chrono::steady_clock::now();
+                    latencies.push_back(std::chrono::duration<double, std::nano>(finish - start).count());
+                    if constexpr (how == Reclaim::DrainBetweenRequests) {
+                        smart_pointer::drain();
+                    }
+                }
+            }
+        }
+        std::sort(latencies.begin(), latencies.end());
+        auto percentile = [&](double p) {
+            return latencies[static_cast<std::size_t>(p * static_cast<double>(latencies.size() - 1))];
+        };
+        state.counters["p50_ns"] = percentile(0.5);
+        state.counters["p99_ns"] = percentile(0.99);
+        state.counters["p999_ns"] = percentile(0.999);
+        state.counters["max_ns"] = latencies.back();
+    }
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_RequestLatency, smart_pointer::atomic_count, Reclaim::Immediately)
+        ->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK_TEMPLATE(BM_RequestLatency, smart_pointer::deferred_count, Reclaim::DrainBetweenRequests)
+        ->Unit(benchmark::kMillisecond)->Iterations(3);
+BENCHMARK_TEMPLATE(BM_RequestLatency, smart_pointer::deferred_count, Reclaim::BackgroundThread)
+        ->Unit(benchmark::kMillisecond)->Iterations(3);
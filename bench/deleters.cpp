@@ -0,0 +1,69 @@
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "shared_ptr.h"
+
+namespace {
+    struct Delete {
+        void operator()(int *ptr) const noexcept {
+            delete ptr;
+        }
+    };
+
+    void delete_int(int *ptr) noexcept {
+        delete ptr;
+    }
+
+    // The baseline: the default deleter of the adopting constructor
+    void BM_DefaultDelete(benchmark::State &state) {
+        for (auto _: state) {
+            smart_pointer::shared_ptr<int> sp(new int(1));
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    // An empty deleter is stored in no bytes, so this should match the baseline
+    void BM_StatelessDeleter(benchmark::State &state) {
+        for (auto _: state) {
+            smart_pointer::shared_ptr<int> sp(new int(1), Delete());
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    void BM_FunctionPointerDeleter(benchmark::State &state) {
+        for (auto _: state) {
+            smart_pointer::shared_ptr<int> sp(new int(1), &delete_int);
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    void BM_StdStatelessDeleter(benchmark::State &state) {
+        for (auto _: state) {
+            std::shared_ptr<int> sp(new int(1), Delete());
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    void BM_AllocateShared(benchmark::State &state) {
+        std::allocator<int> alloc;
+        for (auto _: state) {
+            auto sp = smart_pointer::allocate_shared<int>(alloc, 1);
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    void BM_StdAllocateShared(benchmark::State &state) {
+        std::allocator<int> alloc;
+        for (auto _: state) {
+            auto sp = std::allocate_shared<int>(alloc, 1);
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+}  // namespace
+
+BENCHMARK(BM_DefaultDelete);
+BENCHMARK(BM_StatelessDeleter);
+BENCHMARK(BM_FunctionPointerDeleter);
+BENCHMARK(BM_StdStatelessDeleter);
+BENCHMARK(BM_AllocateShared);
+BENCHMARK(BM_StdAllocateShared);
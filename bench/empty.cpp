@@ -0,0 +1,50 @@
+#include <memory>
+
+#include "allocation_counter.h"
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "shared_ptr.h"
+
+namespace {
+    using fixtures::Animal;
+
+    // The zoo of exe/main.cpp at scale: an array filled with empty pointers.
+    // Only the array itself is allocated, the empty elements cost nothing
+    void BM_FillEmpty(benchmark::State &state) {
+        using PtrToAnimal = smart_pointer::shared_ptr<Animal>;
+        auto before = bench::allocations();
+        for (auto _: state) {
+            auto zoo = smart_pointer::make_shared<PtrToAnimal[]>(state.range(0), PtrToAnimal());
+            benchmark::DoNotOptimize(zoo.get());
+        }
+        bench::report_allocations(state, before);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_StdFillEmpty(benchmark::State &state) {
+        using PtrToAnimal = std::shared_ptr<Animal>;
+        auto before = bench::allocations();
+        for (auto _: state) {
+            auto zoo = std::make_shared<PtrToAnimal[]>(state.range(0), PtrToAnimal());
+            benchmark::DoNotOptimize(zoo.get());
+        }
+        bench::report_allocations(state, before);
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    // Copying and resetting empty pointers must not touch the heap either
+    void BM_CopyEmpty(benchmark::State &state) {
+        smart_pointer::shared_ptr<Animal> empty;
+        auto before = bench::allocations();
+        for (auto _: state) {
+            smart_pointer::shared_ptr<Animal> copy(empty);
+            benchmark::DoNotOptimize(copy.get());
+            copy.reset();
+        }
+        bench::report_allocations(state, before);
+    }
+}  // namespace
+
+BENCHMARK(BM_FillEmpty)->Arg(1 << 20);
+BENCHMARK(BM_StdFillEmpty)->Arg(1 << 20);
+BENCHMARK(BM_CopyEmpty);
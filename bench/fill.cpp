@@ -0,0 +1,106 @@
+#include <algorithm>
+#include <cstddef>
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "shared_ptr.h"
+
+// Throughput of building filled numeric buffers, in bytes of buffer per second. state.range(0) is the size of
+// the buffer in bytes
+
+namespace {
+    // make_shared<T[]>(N, u): a broadcast fill straight into the fresh storage
+    void BM_FillValue(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(float);
+        for (auto _: state) {
+            auto buffer = smart_pointer::make_shared<float[]>(count, 1.5f);
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_StdFillValue(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(float);
+        for (auto _: state) {
+            auto buffer = std::make_shared<float[]>(count, 1.5f);
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+
+    // The old way: new[] value-initialises every element, then each one is assigned
+    void BM_FillValueTwice(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(float);
+        for (auto _: state) {
+            smart_pointer::shared_ptr<float[]> buffer(new float[count]());
+            for (std::size_t i = 0; i < count; ++i) {
+                buffer[i] = 1.5f;
+            }
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+
+    // make_shared<T[][K]>(N, row): the row pattern is copied in bulk
+    void BM_FillRows(benchmark::State &state) {
+        float row[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(row);
+        for (auto _: state) {
+            auto buffer = smart_pointer::make_shared<float[][8]>(count, row);
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_StdFillRows(benchmark::State &state) {
+        float row[8] = {1, 2, 3, 4, 5, 6, 7, 8};
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(row);
+        for (auto _: state) {
+            auto buffer = std::make_shared<float[][8]>(count, row);
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+
+    // make_shared<T[]>(N): value-initialisation, a memset
+    void BM_Zero(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(float);
+        for (auto _: state) {
+            auto buffer = smart_pointer::make_shared<float[]>(count);
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+
+    // make_shared_for_overwrite<T[]>(N) filled by the caller: every byte is written once
+    void BM_ForOverwrite(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(float);
+        for (auto _: state) {
+            auto buffer = smart_pointer::make_shared_for_overwrite<float[]>(count);
+            std::fill_n(buffer.get(), count, 1.5f);
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_StdForOverwrite(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0)) / sizeof(float);
+        for (auto _: state) {
+            auto buffer = std::make_shared_for_overwrite<float[]>(count);
+            std::fill_n(buffer.get(), count, 1.5f);
+            benchmark::DoNotOptimize(buffer.get());
+        }
+        state.SetBytesProcessed(state.iterations() * state.range(0));
+    }
+}  // namespace
+
+#define FILL_BENCHMARK(name) BENCHMARK(name)->Arg(4 << 10)->Arg(1 << 20)->Arg(256 << 20)
+
+FILL_BENCHMARK(BM_FillValue);
+FILL_BENCHMARK(BM_StdFillValue);
+FILL_BENCHMARK(BM_FillValueTwice);
+FILL_BENCHMARK(BM_FillRows);
+FILL_BENCHMARK(BM_StdFillRows);
+FILL_BENCHMARK(BM_Zero);
+FILL_BENCHMARK(BM_ForOverwrite);
+FILL_BENCHMARK(BM_StdForOverwrite);
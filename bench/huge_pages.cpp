@@ -0,0 +1,73 @@
+#include <cstddef>
+#include <cstdint>
+#include <numeric>
+
+#include "benchmark/benchmark.h"
+#include "huge_page_allocator.h"
+#include "shared_ptr.h"
+
+// A streaming read over a big shared buffer, with the buffer taken from the heap (4 KiB pages) or from
+// huge_page_allocator (2 MiB transparent huge pages and a NUMA placement). The buffer is built and touched once
+// before timing, so page faults are not measured, only TLB misses and where the pages are. state.range(0) is
+// the size of the buffer in MiB
+
+namespace {
+    std::size_t doubles(const benchmark::State &state) {
+        return static_cast<std::size_t>(state.range(0)) * (1 << 20) / sizeof(double);
+    }
+
+    template<typename Ptr>
+    void stream(benchmark::State &state, const Ptr &buffer) {
+        std::size_t count = doubles(state);
+        for (auto _: state) {
+            benchmark::DoNotOptimize(std::accumulate(buffer.get(), buffer.get() + count, 0.0));
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(count * sizeof(double)));
+    }
+
+    // Reads with a stride of one 4 KiB page, where every access is a TLB miss on small pages
+    template<typename Ptr>
+    void stride(benchmark::State &state, const Ptr &buffer) {
+        std::size_t count = doubles(state);
+        constexpr std::size_t step = 4096 / sizeof(double);
+        for (auto _: state) {
+            double sum = 0;
+            for (std::size_t offset = 0; offset < step; offset += 8) {
+                for (std::size_t i = offset; i < count; i += step) {
+                    sum += buffer[i];
+                }
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * static_cast<std::int64_t>(count / 8));
+    }
+
+    void BM_StreamHeap(benchmark::State &state) {
+        stream(state, smart_pointer::make_shared<double[]>(doubles(state), 1.0));
+    }
+
+    void BM_StreamHuge(benchmark::State &state) {
+        stream(state, smart_pointer::make_huge_shared<double[]>(smart_pointer::numa_placement::first_touch(),
+                                                                doubles(state), 1.0));
+    }
+
+    void BM_StreamHugeInterleaved(benchmark::State &state) {
+        stream(state, smart_pointer::make_huge_shared<double[]>(smart_pointer::numa_placement::interleaved(),
+                                                                doubles(state), 1.0));
+    }
+
+    void BM_StrideHeap(benchmark::State &state) {
+        stride(state, smart_pointer::make_shared<double[]>(doubles(state), 1.0));
+    }
+
+    void BM_StrideHuge(benchmark::State &state) {
+        stride(state, smart_pointer::make_huge_shared<double[]>(smart_pointer::numa_placement::first_touch(),
+                                                                doubles(state), 1.0));
+    }
+}  // namespace
+
+BENCHMARK(BM_StreamHeap)->Arg(256);
+BENCHMARK(BM_StreamHuge)->Arg(256);
+BENCHMARK(BM_StreamHugeInterleaved)->Arg(256);
+BENCHMARK(BM_StrideHeap)->Arg(256);
+BENCHMARK(BM_StrideHuge)->Arg(256);
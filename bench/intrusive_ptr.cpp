@@ -0,0 +1,154 @@
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "intrusive_ptr.h"
+#include "shared_ptr.h"
+
+namespace {
+    constexpr std::size_t graph_size = 1 << 20;
+    constexpr int degree = 2;
+
+    // A node of a random graph of graph_size nodes with `degree` edges each, holding its edges with Ptr
+    template<template<typename> typename Ptr>
+    struct Node {
+        int value = 0;
+        Ptr<Node> edges[degree];
+    };
+
+    struct IntrusiveNode : smart_pointer::ref_counted<IntrusiveNode> {
+        int value = 0;
+        smart_pointer::intrusive_ptr<IntrusiveNode> edges[degree];
+    };
+
+    template<typename T>
+    using shared = smart_pointer::shared_ptr<T>;
+
+    template<typename T>
+    using std_shared = std::shared_ptr<T>;
+
+    // Builds the graph with the given factory. The nodes are created in a shuffled order, so that neighbours are
+    // not neighbours in memory as well
+    template<typename Ptr, typename Factory>
+    std::vector<Ptr> build_graph(Factory factory) {
+        std::vector<Ptr> nodes(graph_size);
+        std::vector<std::size_t> order(graph_size);
+        for (std::size_t i = 0; i < graph_size; ++i) {
+            order[i] = i;
+        }
+        std::mt19937 random(42);
+        std::shuffle(order.begin(), order.end(), random);
+        for (std::size_t i: order) {
+            nodes[i] = factory();
+            nodes[i]->value = static_cast<int>(i);
+        }
+        std::uniform_int_distribution<std::size_t> pick(0, graph_size - 1);
+        for (auto &node: nodes) {
+            for (auto &edge: node->edges) {
+                edge = nodes[pick(random)];
+            }
+        }
+        return nodes;
+    }
+
+    // Edges form cycles, which reference counting cannot collect: they are cut before the graph goes away
+    template<typename Ptr>
+    void destroy_graph(std::vector<Ptr> &nodes) {
+        for (auto &node: nodes) {
+            for (auto &edge: node->edges) {
+                edge = Ptr();
+            }
+        }
+        nodes.clear();
+    }
+
+    // A walk along the edges that copies the pointer to every visited node, as a traversal keeping its current
+    // node alive does
+    template<typename Ptr, typename Factory>
+    void traverse(benchmark::State &state, Factory factory) {
+        auto nodes = build_graph<Ptr>(factory);
+        std::uint32_t step = 0;
+        for (auto _: state) {
+            Ptr current = nodes[0];
+            long long sum = 0;
+            for (std::size_t i = 0; i < graph_size; ++i) {
+                sum += current->value;
+                step = step * 1664525 + 1013904223;
+                current = current->edges[step >> 31];
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * graph_size);
+        destroy_graph(nodes);
+    }
+
+    // Copies every pointer of the graph: one count update per node, in random memory order
+    template<typename Ptr, typename Factory>
+    void copy_graph(benchmark::State &state, Factory factory) {
+        auto nodes = build_graph<Ptr>(factory);
+        std::vector<Ptr> copies(graph_size);
+        for (auto _: state) {
+            for (std::size_t i = 0; i < graph_size; ++i) {
+                copies[i] = nodes[i]->edges[0];
+            }
+            benchmark::DoNotOptimize(copies.data());
+        }
+        state.SetItemsProcessed(state.iterations() * graph_size);
+        copies.clear();
+        destroy_graph(nodes);
+    }
+
+    void BM_TraverseIntrusive(benchmark::State &state) {
+        using Ptr = smart_pointer::intrusive_ptr<IntrusiveNode>;
+        traverse<Ptr>(state, [] { return smart_pointer::make_intrusive<IntrusiveNode>(); });
+    }
+
+    void BM_TraverseMakeShared(benchmark::State &state) {
+        using Ptr = shared<Node<shared>>;
+        traverse<Ptr>(state, [] { return smart_pointer::make_shared<Node<shared>>(); });
+    }
+
+    // The count in a block of its own: the extra cache miss per copy
+    void BM_TraverseSeparateBlock(benchmark::State &state) {
+        using Ptr = shared<Node<shared>>;
+        traverse<Ptr>(state, [] { return Ptr(new Node<shared>()); });
+    }
+
+    void BM_TraverseStd(benchmark::State &state) {
+        using Ptr = std_shared<Node<std_shared>>;
+        traverse<Ptr>(state, [] { return std::make_shared<Node<std_shared>>(); });
+    }
+
+    void BM_CopyIntrusive(benchmark::State &state) {
+        using Ptr = smart_pointer::intrusive_ptr<IntrusiveNode>;
+        copy_graph<Ptr>(state, [] { return smart_pointer::make_intrusive<IntrusiveNode>(); });
+    }
+
+    void BM_CopyMakeShared(benchmark::State &state) {
+        using Ptr = shared<Node<shared>>;
+        copy_graph<Ptr>(state, [] { return smart_pointer::make_shared<Node<shared>>(); });
+    }
+
+    void BM_CopySeparateBlock(benchmark::State &state) {
+        using Ptr = shared<Node<shared>>;
+        copy_graph<Ptr>(state, [] { return Ptr(new Node<shared>()); });
+    }
+
+    void BM_CopyStd(benchmark::State &state) {
+        using Ptr = std_shared<Node<std_shared>>;
+        copy_graph<Ptr>(state, [] { return std::make_shared<Node<std_shared>>(); });
+    }
+}  // namespace
+
+BENCHMARK(BM_TraverseIntrusive)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TraverseMakeShared)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TraverseSeparateBlock)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_TraverseStd)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CopyIntrusive)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CopyMakeShared)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CopySeparateBlock)->Unit(benchmark::kMillisecond);
+BENCHMARK(BM_CopyStd)->Unit(benchmark::kMillisecond);
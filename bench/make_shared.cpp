@@ -0,0 +1,102 @@
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "shared_ptr.h"
+
+namespace {
+    using fixtures::Animal;
+    using fixtures::Dog;
+
+    // make_shared: one allocation for the object and its control block
+    template<typename T>
+    void BM_MakeShared(benchmark::State &state) {
+        for (auto _: state) {
+            auto sp = smart_pointer::make_shared<T>();
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    // The pre-make_shared path: the object and the control block are allocated separately
+    template<typename T>
+    void BM_TwoAllocations(benchmark::State &state) {
+        for (auto _: state) {
+            smart_pointer::shared_ptr<T> sp(new T());
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    template<typename T>
+    void BM_StdMakeShared(benchmark::State &state) {
+        for (auto _: state) {
+            auto sp = std::make_shared<T>();
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    void BM_MakeSharedArray(benchmark::State &state) {
+        for (auto _: state) {
+            auto sp = smart_pointer::make_shared<int[]>(state.range(0));
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    void BM_TwoAllocationsArray(benchmark::State &state) {
+        for (auto _: state) {
+            smart_pointer::shared_ptr<int[]> sp(new int[state.range(0)]());
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    void BM_StdMakeSharedArray(benchmark::State &state) {
+        for (auto _: state) {
+            auto sp = std::make_shared<int[]>(state.range(0));
+            benchmark::DoNotOptimize(sp.get());
+        }
+    }
+
+    // Dereference plus use_count check over many live pointers: touches one cache line per pointer
+    // with make_shared and two with the separate allocations
+    template<typename Factory>
+    void deref_and_count(benchmark::State &state, Factory factory) {
+        std::vector<decltype(factory())> pointers;
+        for (std::int64_t i = 0; i < state.range(0); ++i) {
+            pointers.push_back(factory());
+        }
+        for (auto _: state) {
+            std::size_t sum = 0;
+            for (const auto &sp: pointers) {
+                sum += *sp + sp.use_count();
+            }
+            benchmark::DoNotOptimize(sum);
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    void BM_DerefMakeShared(benchmark::State &state) {
+        deref_and_count(state, [] { return smart_pointer::make_shared<std::size_t>(1); });
+    }
+
+    void BM_DerefTwoAllocations(benchmark::State &state) {
+        deref_and_count(state, [] { return smart_pointer::shared_ptr<std::size_t>(new std::size_t(1)); });
+    }
+
+    void BM_DerefStdMakeShared(benchmark::State &state) {
+        deref_and_count(state, [] { return std::make_shared<std::size_t>(1); });
+    }
+}  // namespace
+
+BENCHMARK(BM_MakeShared<int>);
+BENCHMARK(BM_TwoAllocations<int>);
+BENCHMARK(BM_StdMakeShared<int>);
+BENCHMARK(BM_MakeShared<Dog>);
+BENCHMARK(BM_TwoAllocations<Dog>);
+BENCHMARK(BM_StdMakeShared<Dog>);
+
+BENCHMARK(BM_MakeSharedArray)->Arg(16)->Arg(1024);
+BENCHMARK(BM_TwoAllocationsArray)->Arg(16)->Arg(1024);
+BENCHMARK(BM_StdMakeSharedArray)->Arg(16)->Arg(1024);
+
+BENCHMARK(BM_DerefMakeShared)->Arg(1 << 16);
+BENCHMARK(BM_DerefTwoAllocations)->Arg(1 << 16);
+BENCHMARK(BM_DerefStdMakeShared)->Arg(1 << 16);
@@ -0,0 +1,97 @@
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <numeric>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "mapped_array.h"
+#include "memory_usage.h"
+#include "shared_ptr.h"
+
+// Loading a 1 GiB file of doubles into a shared array: mapped with map_shared, or read into a buffer from
+// make_shared_for_overwrite. The file is in the page cache after the first run, so both measure memory rather
+// than the disk. Each benchmark reports the peak resident set size of its run
+
+namespace {
+    constexpr std::size_t file_size = std::size_t(1) << 30;
+
+    // Created on first use and removed when the benchmarks end
+    class DataFile {
+    public:
+        DataFile() : path_(std::filesystem::temp_directory_path() / "mapped_array_bench.bin") {
+            std::vector<double> chunk((1 << 20) / sizeof(double), 1.0);
+            std::ofstream out(path_, std::ios::binary);
+            for (std::size_t written = 0; written < file_size; written += chunk.size() * sizeof(double)) {
+                out.write(reinterpret_cast<const char *>(chunk.data()),
+                          static_cast<std::streamsize>(chunk.size() * sizeof(double)));
+            }
+        }
+
+        ~DataFile() {
+            std::filesystem::remove(path_);
+        }
+
+        [[nodiscard]] const std::filesystem::path &path() const {
+            return path_;
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+
+    const std::filesystem::path &data_file() {
+        static DataFile file;
+        return file.path();
+    }
+
+    struct Mapped {
+        static smart_pointer::shared_ptr<const double[]> load() {
+            return smart_pointer::map_shared<const double[]>(data_file()).data;
+        }
+    };
+
+    struct Read {
+        static smart_pointer::shared_ptr<const double[]> load() {
+            auto buffer = smart_pointer::make_shared_for_overwrite<double[]>(file_size / sizeof(double));
+            std::ifstream(data_file(), std::ios::binary).read(reinterpret_cast<char *>(buffer.get()), file_size);
+            return buffer;
+        }
+    };
+
+    void report_peak_rss(benchmark::State &state) {
+        state.counters["peak_rss"] = benchmark::Counter(static_cast<double>(bench::peak_rss()),
+                                                        benchmark::Counter::kDefaults, benchmark::Counter::kIs1024);
+    }
+
+    // From nothing to the first element in hand
+    template<typename Loader>
+    void BM_FirstAccess(benchmark::State &state) {
+        data_file();
+        bench::reset_peak_rss();
+        for (auto _: state) {
+            auto data = Loader::load();
+            benchmark::DoNotOptimize(data[0]);
+        }
+        report_peak_rss(state);
+    }
+
+    // From nothing to the sum of every element
+    template<typename Loader>
+    void BM_FullScan(benchmark::State &state) {
+        data_file();
+        bench::reset_peak_rss();
+        for (auto _: state) {
+            auto data = Loader::load();
+            benchmark::DoNotOptimize(std::accumulate(data.get(), data.get() + file_size / sizeof(double), 0.0));
+        }
+        state.SetBytesProcessed(state.iterations() * static_cast<std::int64_t>(file_size));
+        report_peak_rss(state);
+    }
+}  // namespace
+
+BENCHMARK_TEMPLATE(BM_FirstAccess, Mapped)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FirstAccess, Read)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FullScan, Mapped)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_FullScan, Read)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,36 @@
+#include <cstdio>
+#include <cstring>
+
+#include <sys/resource.h>
+
+#include "memory_usage.h"
+
+namespace bench {
+    void reset_peak_rss() noexcept {
+        // Writing 5 to clear_refs resets VmHWM on Linux; elsewhere the peak simply keeps growing
+        if (std::FILE *refs = std::fopen("/proc/self/clear_refs", "w")) {
+            std::fputs("5", refs);
+            std::fclose(refs);
+        }
+    }
+
+    std::size_t peak_rss() noexcept {
+        if (std::FILE *status = std::fopen("/proc/self/status", "r")) {
+            char line[256];
+            std::size_t kilobytes = 0;
+            while (std::fgets(line, sizeof(line), status)) {
+                if (std::strncmp(line, "VmHWM:", 6) == 0) {
+                    std::sscanf(line + 6, "%zu", &kilobytes);
+                    break;
+                }
+            }
+            std::fclose(status);
+            if (kilobytes) {
+                return kilobytes * 1024;
+            }
+        }
+        rusage usage{};
+        getrusage(RUSAGE_SELF, &usage);
+        return static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+    }
+}  // namespace bench
@@ -0,0 +1,14 @@
+#ifndef MP_CPP_HW1_MEMORY_USAGE
+#define MP_CPP_HW1_MEMORY_USAGE
+
+#include <cstddef>  // std::size_t
+
+namespace bench {
+    // Forget the peak resident set size measured so far, where the system allows it
+    void reset_peak_rss() noexcept;
+
+    // Peak resident set size of the process in bytes
+    std::size_t peak_rss() noexcept;
+}  // namespace bench
+
+#endif  // MP_CPP_HW1_MEMORY_USAGE
@@ -0,0 +1,319 @@
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "shared_ptr.h"
+
+// Every public operation of shared_ptr, for every kind of managed type, next to the same operation of
+// std::shared_ptr. Each benchmark also reports the heap allocations it makes per operation
+
+namespace {
+    using fixtures::Animal;
+    using fixtures::Dog;
+
+    // The library under test
+    struct Ours {
+        template<typename T>
+        using ptr = smart_pointer::shared_ptr<T>;
+
+        template<typename T, typename... Args>
+        static auto make(Args &&... args) {
+            return smart_pointer::make_shared<T>(std::forward<Args>(args)...);
+        }
+    };
+
+    // The reference
+    struct Std {
+        template<typename T>
+        using ptr = std::shared_ptr<T>;
+
+        template<typename T, typename... Args>
+        static auto make(Args &&... args) {
+            return std::make_shared<T>(std::forward<Args>(args)...);
+        }
+    };
+
+    // The kinds of managed types: how to create one with make_shared or with new, and how to use it
+
+    struct Scalar {
+        using type = int;
+
+        template<typename Lib>
+        static typename Lib::template ptr<type> make() {
+            return Lib::template make<int>(42);
+        }
+
+        static int *raw() {
+            return new int(42);
+        }
+
+        template<typename Ptr>
+        static int access(const Ptr &ptr) {
+            return *ptr;
+        }
+    };
+
+    struct Polymorphic {
+        using type = Animal;
+
+        template<typename Lib>
+        static typename Lib::template ptr<type> make() {
+            return Lib::template make<Dog>();
+        }
+
+        static Animal *raw() {
+            return new Dog();
+        }
+
+        template<typename Ptr>
+        static int access(const Ptr &ptr) {
+            return ptr->legs();
+        }
+    };
+
+    struct Array {
+        using type = int[];
+
+        template<typename Lib>
+        static typename Lib::template ptr<type> make() {
+            return Lib::template make<int[]>(16);
+        }
+
+        static int *raw() {
+            return new int[16]();
+        }
+
+        template<typename Ptr>
+        static int access(const Ptr &ptr) {
+            return ptr[15];
+        }
+    };
+
+    struct MultiArray {
+        using type = int[][4];
+
+        template<typename Lib>
+        static typename Lib::template ptr<type> make() {
+            return Lib::template make<int[][4]>(4);
+        }
+
+        static int (*raw())[4] {
+            return new int[4][4]();
+        }
+
+        template<typename Ptr>
+        static int access(const Ptr &ptr) {
+            return ptr[3][3];
+        }
+    };
+
+    template<typename Lib, typename Kind>
+    using pointer = typename Lib::template ptr<typename Kind::type>;
+
+    template<typename Lib, typename Kind>
+    void BM_DefaultConstruct(benchmark::State &state) {
+        auto before = bench::allocations();
+        for (auto _: state) {
+            pointer<Lib, Kind> ptr;
+            benchmark::DoNotOptimize(ptr);
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // Construction from a raw pointer and destruction, including the new and delete of the object
+    template<typename Lib, typename Kind>
+    void BM_ConstructFromRaw(benchmark::State &state) {
+        auto before = bench::allocations();
+        for (auto _: state) {
+            pointer<Lib, Kind> ptr(Kind::raw());
+            benchmark::DoNotOptimize(ptr.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // Same with a custom deleter
+    template<typename Lib, typename Kind>
+    void BM_ConstructWithDeleter(benchmark::State &state) {
+        auto before = bench::allocations();
+        for (auto _: state) {
+            auto obj = Kind::raw();
+            pointer<Lib, Kind> ptr(obj, [](auto *ptr) {
+                if constexpr (std::is_array_v<typename Kind::type>) {
+                    delete[] ptr;
+                } else {
+                    delete ptr;
+                }
+            });
+            benchmark::DoNotOptimize(ptr.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // make_shared and destruction
+    template<typename Lib, typename Kind>
+    void BM_MakeShared(benchmark::State &state) {
+        auto before = bench::allocations();
+        for (auto _: state) {
+            auto ptr = Kind::template make<Lib>();
+            benchmark::DoNotOptimize(ptr.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // Copy construction and destruction of the copy
+    template<typename Lib, typename Kind>
+    void BM_Copy(benchmark::State &state) {
+        auto source = Kind::template make<Lib>();
+        auto before = bench::allocations();
+        for (auto _: state) {
+            pointer<Lib, Kind> copy(source);
+            benchmark::DoNotOptimize(copy.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // Move construction; the pointer is moved back by assignment for the next iteration
+    template<typename Lib, typename Kind>
+    void BM_Move(benchmark::State &state) {
+        auto source = Kind::template make<Lib>();
+        auto before = bench::allocations();
+        for (auto _: state) {
+            pointer<Lib, Kind> moved(std::move(source));
+            benchmark::DoNotOptimize(moved.get());
+            source = std::move(moved);
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // Copy assignment of two different objects in turn, releasing the previous one each time
+    template<typename Lib, typename Kind>
+    void BM_CopyAssign(benchmark::State &state) {
+        auto first = Kind::template make<Lib>();
+        auto second = Kind::template make<Lib>();
+        pointer<Lib, Kind> target;
+        auto before = bench::allocations();
+        for (auto _: state) {
+            target = first;
+            target = second;
+            benchmark::DoNotOptimize(target.get());
+        }
+        bench::report_allocations(state, before);
+        state.SetItemsProcessed(state.iterations() * 2);
+    }
+
+    // Move assignment there and back
+    template<typename Lib, typename Kind>
+    void BM_MoveAssign(benchmark::State &state) {
+        auto first = Kind::template make<Lib>();
+        pointer<Lib, Kind> second;
+        auto before = bench::allocations();
+        for (auto _: state) {
+            second = std::move(first);
+            first = std::move(second);
+            benchmark::DoNotOptimize(first.get());
+        }
+        bench::report_allocations(state, before);
+        state.SetItemsProcessed(state.iterations() * 2);
+    }
+
+    // reset() of a copy: the count goes down, the object stays
+    template<typename Lib, typename Kind>
+    void BM_Reset(benchmark::State &state) {
+        auto source = Kind::template make<Lib>();
+        auto before = bench::allocations();
+        for (auto _: state) {
+            pointer<Lib, Kind> copy(source);
+            copy.reset();
+            benchmark::DoNotOptimize(copy.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // reset(ptr): destroys the previous object and adopts a new one
+    template<typename Lib, typename Kind>
+    void BM_ResetRaw(benchmark::State &state) {
+        auto ptr = Kind::template make<Lib>();
+        auto before = bench::allocations();
+        for (auto _: state) {
+            ptr.reset(Kind::raw());
+            benchmark::DoNotOptimize(ptr.get());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    template<typename Lib, typename Kind>
+    void BM_UseCount(benchmark::State &state) {
+        auto ptr = Kind::template make<Lib>();
+        auto before = bench::allocations();
+        for (auto _: state) {
+            benchmark::DoNotOptimize(ptr);
+            benchmark::DoNotOptimize(ptr.use_count());
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // get(), operator bool and *, -> or [] depending on the type
+    template<typename Lib, typename Kind>
+    void BM_Access(benchmark::State &state) {
+        auto ptr = Kind::template make<Lib>();
+        auto before = bench::allocations();
+        for (auto _: state) {
+            benchmark::DoNotOptimize(ptr);
+            benchmark::DoNotOptimize(ptr.get());
+            benchmark::DoNotOptimize(static_cast<bool>(ptr));
+            benchmark::DoNotOptimize(Kind::access(ptr));
+        }
+        bench::report_allocations(state, before);
+    }
+
+    // Destruction of the last owner, timed apart from the creation of the pointers
+    template<typename Lib, typename Kind>
+    void BM_Destroy(benchmark::State &state) {
+        constexpr std::size_t batch = 1024;
+        std::vector<pointer<Lib, Kind>> pointers;
+        pointers.reserve(batch);
+        auto before = bench::allocations();
+        for (auto _: state) {
+            state.PauseTiming();
+            auto paused = bench::allocations();
+            for (std::size_t i = 0; i < batch; ++i) {
+                pointers.push_back(Kind::template make<Lib>());
+            }
+            // Only the allocations made while destroying count
+            before += bench::allocations() - paused;
+            state.ResumeTiming();
+            pointers.clear();
+        }
+        bench::report_allocations(state, before);
+        state.SetItemsProcessed(state.iterations() * batch);
+    }
+}  // namespace
+
+#define SMART_POINTER_BENCHMARK(name)                   \
+    BENCHMARK_TEMPLATE(name, Ours, Scalar);             \
+    BENCHMARK_TEMPLATE(name, Std, Scalar);              \
+    BENCHMARK_TEMPLATE(name, Ours, Polymorphic);        \
+    BENCHMARK_TEMPLATE(name, Std, Polymorphic);         \
+    BENCHMARK_TEMPLATE(name, Ours, Array);              \
+    BENCHMARK_TEMPLATE(name, Std, Array);               \
+    BENCHMARK_TEMPLATE(name, Ours, MultiArray);         \
+    BENCHMARK_TEMPLATE(name, Std, MultiArray)
+
+SMART_POINTER_BENCHMARK(BM_DefaultConstruct);
+SMART_POINTER_BENCHMARK(BM_ConstructFromRaw);
+SMART_POINTER_BENCHMARK(BM_ConstructWithDeleter);
+SMART_POINTER_BENCHMARK(BM_MakeShared);
+SMART_POINTER_BENCHMARK(BM_Copy);
+SMART_POINTER_BENCHMARK(BM_Move);
+SMART_POINTER_BENCHMARK(BM_CopyAssign);
+SMART_POINTER_BENCHMARK(BM_MoveAssign);
+SMART_POINTER_BENCHMARK(BM_Reset);
+SMART_POINTER_BENCHMARK(BM_ResetRaw);
+SMART_POINTER_BENCHMARK(BM_UseCount);
+SMART_POINTER_BENCHMARK(BM_Access);
+SMART_POINTER_BENCHMARK(BM_Destroy);
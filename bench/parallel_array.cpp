@@ -0,0 +1,87 @@
+#include <cstddef>
+#include <execution>
+#include <string>
+
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "parallel_array.h"
+#include "shared_ptr.h"
+
+// Wall time to construct, and separately to destroy, big arrays of non-trivial elements with make_shared on one
+// thread and with make_shared(std::execution::par, ...). state.range(0) is the number of elements
+
+namespace {
+    using fixtures::Animal;
+
+    using PtrToAnimal = smart_pointer::shared_ptr<Animal>;
+
+    struct Serial {
+        template<typename T>
+        static auto make(std::size_t count, const std::remove_extent_t<T> &u) {
+            return smart_pointer::make_shared<T>(count, u);
+        }
+    };
+
+    struct Parallel {
+        template<typename T>
+        static auto make(std::size_t count, const std::remove_extent_t<T> &u) {
+            return smart_pointer::make_shared<T>(std::execution::par, count, u);
+        }
+    };
+
+    // Elements like the ones of exe/main.cpp: shared_ptrs, all copied from the same one. Every copy updates the
+    // same counter, which limits how well construction and destruction scale
+    struct Pointers {
+        using type = PtrToAnimal[];
+
+        static PtrToAnimal pattern() {
+            return smart_pointer::make_shared<Animal>();
+        }
+    };
+
+    // Strings too long for the small string optimisation: every element allocates
+    struct Strings {
+        using type = std::string[];
+
+        static std::string pattern() {
+            return std::string(40, 'x');
+        }
+    };
+
+    template<typename How, typename Elements>
+    void BM_Construct(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0));
+        auto pattern = Elements::pattern();
+        for (auto _: state) {
+            auto array = How::template make<typename Elements::type>(count, pattern);
+            benchmark::DoNotOptimize(array.get());
+            state.PauseTiming();
+            array.reset();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+
+    template<typename How, typename Elements>
+    void BM_Destroy(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0));
+        auto pattern = Elements::pattern();
+        for (auto _: state) {
+            state.PauseTiming();
+            auto array = How::template make<typename Elements::type>(count, pattern);
+            benchmark::DoNotOptimize(array.get());
+            state.ResumeTiming();
+            array.reset();
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}  // namespace
+
+#define PARALLEL_BENCHMARK(name, elements, ...)                                                          \
+    BENCHMARK_TEMPLATE(name, Serial, elements)->__VA_ARGS__->Unit(benchmark::kMillisecond)->UseRealTime(); \
+    BENCHMARK_TEMPLATE(name, Parallel, elements)->__VA_ARGS__->Unit(benchmark::kMillisecond)->UseRealTime()
+
+PARALLEL_BENCHMARK(BM_Construct, Pointers, Arg(10'000'000)->Arg(100'000'000));
+PARALLEL_BENCHMARK(BM_Destroy, Pointers, Arg(10'000'000)->Arg(100'000'000));
+PARALLEL_BENCHMARK(BM_Construct, Strings, Arg(10'000'000));
+PARALLEL_BENCHMARK(BM_Destroy, Strings, Arg(10'000'000));
@@ -0,0 +1,63 @@
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "shared_ptr.h"
+
+namespace {
+    // Every thread copies and destroys copies of one pointer: all of them hit the same counter
+    template<typename Ptr, typename Factory>
+    void copy_shared(benchmark::State &state, Factory factory) {
+        static Ptr shared;
+        if (state.thread_index() == 0) {
+            shared = factory();
+        }
+        for (auto _: state) {
+            Ptr copy(shared);
+            benchmark::DoNotOptimize(copy.get());
+        }
+        if (state.thread_index() == 0) {
+            shared = Ptr();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    // Every thread copies its own pointer: measures the cost of the counter update without contention
+    template<typename Ptr, typename Factory>
+    void copy_private(benchmark::State &state, Factory factory) {
+        Ptr own = factory();
+        for (auto _: state) {
+            Ptr copy(own);
+            benchmark::DoNotOptimize(copy.get());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_SharedAtomic(benchmark::State &state) {
+        copy_shared<smart_pointer::shared_ptr<int>>(state, [] { return smart_pointer::make_shared<int>(); });
+    }
+
+    void BM_SharedStd(benchmark::State &state) {
+        copy_shared<std::shared_ptr<int>>(state, [] { return std::make_shared<int>(); });
+    }
+
+    void BM_PrivateAtomic(benchmark::State &state) {
+        copy_private<smart_pointer::shared_ptr<int>>(state, [] { return smart_pointer::make_shared<int>(); });
+    }
+
+    void BM_PrivateLocal(benchmark::State &state) {
+        copy_private<smart_pointer::local_shared_ptr<int>>(state, [] {
+            return smart_pointer::make_shared<int, smart_pointer::local_count>();
+        });
+    }
+
+    void BM_PrivateStd(benchmark::State &state) {
+        copy_private<std::shared_ptr<int>>(state, [] { return std::make_shared<int>(); });
+    }
+}  // namespace
+
+// local_count must not be shared between threads, so it only takes part in the private benchmarks
+BENCHMARK(BM_SharedAtomic)->ThreadRange(1, 8);
+BENCHMARK(BM_SharedStd)->ThreadRange(1, 8);
+BENCHMARK(BM_PrivateAtomic)->ThreadRange(1, 8);
+BENCHMARK(BM_PrivateLocal)->ThreadRange(1, 8);
+BENCHMARK(BM_PrivateStd)->ThreadRange(1, 8);
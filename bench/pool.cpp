@@ -0,0 +1,95 @@
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "memory_usage.h"
+#include "pool_allocator.h"
+#include "shared_ptr.h"
+
+namespace {
+    using fixtures::Dog;
+
+    // Every thread creates its share of state.range(0) pointers, keeps them all alive and then drops them.
+    // Reports the time per pointer and the peak resident set size of the whole run
+    template<typename Ptr, typename Factory>
+    void create_destroy(benchmark::State &state, Factory factory) {
+        auto count = static_cast<std::size_t>(state.range(0) / state.threads());
+        if (state.thread_index() == 0) {
+            bench::reset_peak_rss();
+        }
+        std::vector<Ptr> pointers;
+        pointers.reserve(count);
+        for (auto _: state) {
+            for (std::size_t i = 0; i < count; ++i) {
+                pointers.push_back(factory());
+            }
+            benchmark::DoNotOptimize(pointers.data());
+            pointers.clear();
+        }
+        state.SetItemsProcessed(state.iterations() * count);
+        if (state.thread_index() == 0) {
+            state.counters["peak_rss"] = benchmark::Counter(static_cast<double>(bench::peak_rss()),
+                                                            benchmark::Counter::kDefaults,
+                                                            benchmark::Counter::kIs1024);
+        }
+    }
+
+    void BM_Int(benchmark::State &state) {
+        create_destroy<smart_pointer::shared_ptr<int>>(state, [] { return smart_pointer::make_shared<int>(); });
+    }
+
+    void BM_PooledInt(benchmark::State &state) {
+        create_destroy<smart_pointer::shared_ptr<int>>(state, [] {
+            return smart_pointer::make_pooled_shared<int>();
+        });
+    }
+
+    void BM_StdInt(benchmark::State &state) {
+        create_destroy<std::shared_ptr<int>>(state, [] { return std::make_shared<int>(); });
+    }
+
+    void BM_Dog(benchmark::State &state) {
+        create_destroy<smart_pointer::shared_ptr<Dog>>(state, [] { return smart_pointer::make_shared<Dog>(); });
+    }
+
+    void BM_PooledDog(benchmark::State &state) {
+        create_destroy<smart_pointer::shared_ptr<Dog>>(state, [] {
+            return smart_pointer::make_pooled_shared<Dog>();
+        });
+    }
+
+    void BM_StdDog(benchmark::State &state) {
+        create_destroy<std::shared_ptr<Dog>>(state, [] { return std::make_shared<Dog>(); });
+    }
+
+    // Pointers built on one thread and dropped on another: the pool takes the remote free path
+    void BM_PooledHandOff(benchmark::State &state) {
+        std::vector<smart_pointer::shared_ptr<int>> pointers(static_cast<std::size_t>(state.range(0)));
+        for (auto _: state) {
+            std::thread producer([&pointers] {
+                for (auto &pointer: pointers) {
+                    pointer = smart_pointer::make_pooled_shared<int>();
+                }
+            });
+            producer.join();
+            for (auto &pointer: pointers) {
+                pointer.reset();
+            }
+        }
+        state.SetItemsProcessed(state.iterations() * state.range(0));
+    }
+}  // namespace
+
+// Neither the pool nor malloc give memory back to the system, so peak_rss includes what earlier benchmarks left
+// resident; run one benchmark at a time with --benchmark_filter for isolated figures
+constexpr int pointers = 10'000'000;
+
+BENCHMARK(BM_Int)->Arg(pointers)->ThreadRange(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_PooledInt)->Arg(pointers)->ThreadRange(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_StdInt)->Arg(pointers)->ThreadRange(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_Dog)->Arg(pointers)->ThreadRange(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_PooledDog)->Arg(pointers)->ThreadRange(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_StdDog)->Arg(pointers)->ThreadRange(1, 4)->Unit(benchmark::kMillisecond)->UseRealTime();
+BENCHMARK(BM_PooledHandOff)->Arg(1 << 20)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,73 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "benchmark/benchmark.h"
+#include "shared_ptr.h"
+
+// A callback-heavy loop: every iteration each of state.range(0) timers schedules a callback that keeps it alive,
+// then the callbacks run and are dropped. Compares shared_from_this() with locking weak_from_this(), which also
+// takes and drops a weak reference, and with std::enable_shared_from_this. `allocs` is the number of heap
+// allocations per iteration
+
+namespace {
+    struct Timer : smart_pointer::enable_shared_from_this<Timer> {
+        std::size_t fired = 0;
+
+        void fire() {
+            ++fired;
+        }
+    };
+
+    struct StdTimer : std::enable_shared_from_this<StdTimer> {
+        std::size_t fired = 0;
+
+        void fire() {
+            ++fired;
+        }
+    };
+
+    template<typename Pointer, typename Make, typename Share>
+    void run_callbacks(benchmark::State &state, Make make, Share share) {
+        auto count = static_cast<std::size_t>(state.range(0));
+        std::vector<Pointer> timers;
+        for (std::size_t i = 0; i < count; ++i) {
+            timers.push_back(make());
+        }
+        std::vector<Pointer> callbacks;
+        callbacks.reserve(count);
+        std::size_t before = bench::allocations();
+        for (auto _: state) {
+            for (auto &timer: timers) {
+                callbacks.push_back(share(*timer));
+            }
+            for (auto &callback: callbacks) {
+                callback->fire();
+            }
+            callbacks.clear();
+        }
+        bench::report_allocations(state, before);
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+    }
+
+    void BM_SharedFromThis(benchmark::State &state) {
+        run_callbacks<smart_pointer::shared_ptr<Timer>>(state, [] { return smart_pointer::make_shared<Timer>(); },
+                                                        [](Timer &timer) { return timer.shared_from_this(); });
+    }
+
+    void BM_LockWeakFromThis(benchmark::State &state) {
+        run_callbacks<smart_pointer::shared_ptr<Timer>>(state, [] { return smart_pointer::make_shared<Timer>(); },
+                                                        [](Timer &timer) { return timer.weak_from_this().lock(); });
+    }
+
+    void BM_StdSharedFromThis(benchmark::State &state) {
+        run_callbacks<std::shared_ptr<StdTimer>>(state, [] { return std::make_shared<StdTimer>(); },
+                                                 [](StdTimer &timer) { return timer.shared_from_this(); });
+    }
+}  // namespace
+
+BENCHMARK(BM_SharedFromThis)->Arg(1024);
+BENCHMARK(BM_LockWeakFromThis)->Arg(1024);
+BENCHMARK(BM_StdSharedFromThis)->Arg(1024);
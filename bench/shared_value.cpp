@@ -0,0 +1,76 @@
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+#include "allocation_counter.h"
+#include "benchmark/benchmark.h"
+#include "memory_usage.h"
+#include "shared_ptr.h"
+#include "shared_value.h"
+
+// A hash map from ids to small immutable records, held by shared_value or by shared_ptr. The map is built once per
+// benchmark; the time measured is the one of random lookups reading the record. Reports the memory the map added to
+// the peak resident set size and the heap allocations it made, per entry, and the lookups per second
+
+namespace {
+    struct Quote {
+        std::int32_t bid;
+        std::int32_t ask;
+    };
+
+    constexpr std::size_t lookups = 1 << 20;
+
+    template<typename Handle>
+    Handle make_quote(std::int32_t bid, std::int32_t ask) {
+        if constexpr (std::is_same_v<Handle, smart_pointer::shared_value<Quote>>) {
+            return smart_pointer::make_shared_value<Quote>(bid, ask);
+        } else {
+            return smart_pointer::make_shared<Quote>(Quote{bid, ask});
+        }
+    }
+
+    template<typename Handle>
+    void BM_HashMap(benchmark::State &state) {
+        auto entries = static_cast<std::size_t>(state.range(0));
+        bench::reset_peak_rss();
+        std::size_t before = bench::peak_rss();
+        std::size_t allocations = bench::allocations();
+        std::unordered_map<std::uint64_t, Handle> quotes;
+        quotes.reserve(entries);
+        for (std::size_t id = 0; id < entries; ++id) {
+            quotes.emplace(id, make_quote<Handle>(static_cast<std::int32_t>(id), static_cast<std::int32_t>(id + 1)));
+        }
+        std::size_t after = bench::peak_rss();
+        allocations = bench::allocations() - allocations;
+
+        std::mt19937_64 random(42);
+        std::uniform_int_distribution<std::uint64_t> ids(0, entries - 1);
+        std::vector<std::uint64_t> keys(lookups);
+        for (auto &key: keys) {
+            key = ids(random);
+        }
+        for (auto _: state) {
+            std::int64_t spread = 0;
+            for (std::uint64_t key: keys) {
+                const Handle &quote = quotes.find(key)->second;
+                spread += quote->ask - quote->bid;
+            }
+            benchmark::DoNotOptimize(spread);
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * lookups));
+        state.counters["bytes_per_entry"] = static_cast<double>(after - before) / static_cast<double>(entries);
+        state.counters["allocations_per_entry"] = static_cast<double>(allocations) / static_cast<double>(entries);
+    }
+}  // namespace
+
+// A fixed number of iterations builds the map only once. Freed memory stays resident, so the second benchmark may
+// reuse what the first left: run one at a time with --benchmark_filter for isolated figures
+constexpr int entries = 10'000'000;
+
+BENCHMARK_TEMPLATE(BM_HashMap, smart_pointer::shared_value<Quote>)
+        ->Arg(entries)->Iterations(10)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_HashMap, smart_pointer::shared_ptr<Quote>)
+        ->Arg(entries)->Iterations(10)->Unit(benchmark::kMillisecond);
@@ -0,0 +1,83 @@
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "fixtures.h"
+#include "shared_ptr.h"
+#include "vector.h"
+
+// Containers of 10M shared pointers. smart_pointer::vector relocates the trivially relocatable
+// smart_pointer::shared_ptr with memcpy and memmove; std::vector runs a move constructor and a destructor per element
+// when it grows, and a move assignment per element when it shifts them
+
+namespace {
+    using fixtures::Animal;
+
+    // `count` pointers to a thousand animals
+    template<typename Container>
+    Container make_pointers(std::size_t count) {
+        using pointer = typename Container::value_type;
+        std::vector<pointer> animals;
+        for (std::size_t i = 0; i < 1000; ++i) {
+            animals.push_back(fixtures::make<pointer>());
+        }
+        Container pointers;
+        pointers.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            pointers.push_back(animals[i % animals.size()]);
+        }
+        return pointers;
+    }
+
+    // Move state.range(0) pointers one by one into an empty container, which grows as it goes. The counts are not
+    // touched: only the growth of the container is measured
+    template<typename Container>
+    void BM_PushBack(benchmark::State &state) {
+        auto count = static_cast<std::size_t>(state.range(0));
+        auto source = make_pointers<Container>(count);
+        for (auto _: state) {
+            Container pointers;
+            for (auto &pointer: source) {
+                pointers.push_back(std::move(pointer));
+            }
+            state.PauseTiming();
+            for (std::size_t i = 0; i < count; ++i) {
+                source[i] = std::move(pointers[i]);
+            }
+            pointers = Container();
+            state.ResumeTiming();
+        }
+        state.SetItemsProcessed(static_cast<std::int64_t>(state.iterations() * count));
+    }
+
+    // Erase the pointer in the middle of a container of state.range(0) pointers and insert it back: every operation
+    // shifts half the pointers by one place
+    template<typename Container>
+    void BM_EraseInsert(benchmark::State &state) {
+        auto pointers = make_pointers<Container>(static_cast<std::size_t>(state.range(0)));
+        std::size_t middle = pointers.size() / 2;
+        for (auto _: state) {
+            auto pointer = std::move(pointers[middle]);
+            pointers.erase(pointers.begin() + middle);
+            pointers.insert(pointers.begin() + middle, std::move(pointer));
+            benchmark::DoNotOptimize(pointers.data());
+        }
+        state.SetItemsProcessed(state.iterations() * 2);
+    }
+}  // namespace
+
+constexpr int pointers = 10'000'000;
+
+BENCHMARK_TEMPLATE(BM_PushBack, smart_pointer::vector<smart_pointer::shared_ptr<Animal>>)
+        ->Arg(pointers)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBack, std::vector<smart_pointer::shared_ptr<Animal>>)
+        ->Arg(pointers)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_PushBack, std::vector<std::shared_ptr<Animal>>)->Arg(pointers)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_EraseInsert, smart_pointer::vector<smart_pointer::shared_ptr<Animal>>)
+        ->Arg(pointers)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_EraseInsert, std::vector<smart_pointer::shared_ptr<Animal>>)
+        ->Arg(pointers)->Unit(benchmark::kMillisecond);
+BENCHMARK_TEMPLATE(BM_EraseInsert, std::vector<std::shared_ptr<Animal>>)->Arg(pointers)->Unit(benchmark::kMillisecond);
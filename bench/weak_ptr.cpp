@@ -0,0 +1,50 @@
+#include <memory>
+
+#include "benchmark/benchmark.h"
+#include "shared_ptr.h"
+
+namespace {
+    // All threads lock the same weak_ptr while one owner keeps the object alive
+    template<typename Owner, typename Observer, typename Factory>
+    void lock_shared(benchmark::State &state, Factory factory) {
+        static Owner owner;
+        static Observer observer;
+        if (state.thread_index() == 0) {
+            owner = factory();
+            observer = owner;
+        }
+        for (auto _: state) {
+            auto locked = observer.lock();
+            benchmark::DoNotOptimize(locked.get());
+        }
+        if (state.thread_index() == 0) {
+            observer = Observer();
+            owner = Owner();
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+
+    void BM_WeakLock(benchmark::State &state) {
+        lock_shared<smart_pointer::shared_ptr<int>, smart_pointer::weak_ptr<int>>(state, [] {
+            return smart_pointer::make_shared<int>();
+        });
+    }
+
+    void BM_StdWeakLock(benchmark::State &state) {
+        lock_shared<std::shared_ptr<int>, std::weak_ptr<int>>(state, [] { return std::make_shared<int>(); });
+    }
+
+    void BM_WeakLockLocal(benchmark::State &state) {
+        smart_pointer::local_shared_ptr<int> owner = smart_pointer::make_shared<int, smart_pointer::local_count>();
+        smart_pointer::weak_ptr<int, smart_pointer::local_count> observer(owner);
+        for (auto _: state) {
+            auto locked = observer.lock();
+            benchmark::DoNotOptimize(locked.get());
+        }
+        state.SetItemsProcessed(state.iterations());
+    }
+}  // namespace
+
+BENCHMARK(BM_WeakLock)->ThreadRange(1, 8);
+BENCHMARK(BM_StdWeakLock)->ThreadRange(1, 8);
+BENCHMARK(BM_WeakLockLocal);
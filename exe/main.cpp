@@ -48,7 +48,7 @@ int main() {
     auto zoo = smart_pointer::make_shared<PtrToAnimal[]>(length, PtrToAnimal());
 
     // Now you are to fill the array with cats and dogs. 'Cat' is for cat, 'Dog' is for dog"
-    for (std::size_t i = 0; i < length; ++i) {
+    for (std::size_t i = 0; i < zoo.size(); ++i) {
         std::string type;
         std::cin >> type;  // Enter the type
         if (type == "Dog") {
@@ -70,7 +70,7 @@ int main() {
         if (index == 0) {
             break;
         }
-        if (index > length) {
+        if (index > zoo.size()) {
             std::cout << "Please, enter a valid index of the animal: ";
             continue;
         }
@@ -78,5 +78,9 @@ int main() {
         zoo[index - 1]->speak();
     }
 
+#ifdef MP_CPP_HW1_INSTRUMENT
+    // Built with the instrumentation: report what the program has done with its shared_ptrs
+    std::cerr << smart_pointer::instrumentation::take_snapshot().to_json() << std::endl;
+#endif
     return 0;
 }
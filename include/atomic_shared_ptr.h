@@ -0,0 +1,268 @@
+#ifndef MP_CPP_HW1_ATOMIC_SHARED_PTR
+#define MP_CPP_HW1_ATOMIC_SHARED_PTR
+
+#include <atomic>  // std::atomic, std::memory_order
+#include <cstdint>  // std::uint64_t, std::int64_t, std::uintptr_t
+#include <utility>  // std::move
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // A shared_ptr that can be loaded, stored and exchanged from many threads at once without locks.
+    //
+    // The value lives in a node that is published through a single 64-bit word holding the address of the node
+    // in the upper 48 bits and a local count in the lower 16. A reader bumps the local count with one fetch_add,
+    // which pins the node, copies the shared_ptr out of it and takes its pin back by decrementing the local count.
+    // A writer swaps in a new node and moves the local count of the old one to the node's own count, which readers
+    // whose pin was moved decrement instead; whoever brings it to zero deletes the node.
+    //
+    // All operations are sequentially consistent; the memory_order arguments exist for compatibility with
+    // std::atomic. Up to 65535 loads may be in flight at the same time
+    template<typename T>
+    class atomic_shared_ptr {
+    public:
+        using value_type = shared_ptr<T>;
+
+        static constexpr bool is_always_lock_free = std::atomic<std::uint64_t>::is_always_lock_free;
+
+        // Constructs an atomic_shared_ptr holding an empty shared_ptr
+        constexpr atomic_shared_ptr() noexcept = default;
+
+        // Constructs an atomic_shared_ptr holding the given value
+        atomic_shared_ptr(shared_ptr<T> desired);
+
+        atomic_shared_ptr(const atomic_shared_ptr &) = delete;
+
+        atomic_shared_ptr &operator=(const atomic_shared_ptr &) = delete;
+
+        // Destructor. Must not run concurrently with any other operation
+        ~atomic_shared_ptr();
+
+        // Same as store(desired)
+        void operator=(shared_ptr<T> desired);
+
+        // Same as load()
+        operator shared_ptr<T>() const;
+
+        [[nodiscard]] bool is_lock_free() const noexcept;
+
+        // Get a copy of the stored value
+        shared_ptr<T> load(std::memory_order order = std::memory_order_seq_cst) const;
+
+        // Replace the stored value
+        void store(shared_ptr<T> desired, std::memory_order order = std::memory_order_seq_cst);
+
+        // Replace the stored value and return the previous one
+        shared_ptr<T> exchange(shared_ptr<T> desired, std::memory_order order = std::memory_order_seq_cst);
+
+        // Replace the stored value with `desired` if it points to the same object and shares ownership with
+        // `expected`; otherwise load the stored value into `expected`
+        bool compare_exchange_strong(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                     std::memory_order order = std::memory_order_seq_cst);
+
+        bool compare_exchange_strong(shared_ptr<T> &expected, shared_ptr<T> desired, std::memory_order success,
+                                     std::memory_order failure);
+
+        // Never fails spuriously, so it is the same as compare_exchange_strong
+        bool compare_exchange_weak(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                   std::memory_order order = std::memory_order_seq_cst);
+
+        bool compare_exchange_weak(shared_ptr<T> &expected, shared_ptr<T> desired, std::memory_order success,
+                                   std::memory_order failure);
+
+    private:
+        struct node {
+            shared_ptr<T> value;
+            // Pins moved here from the published word minus the pins returned since; starts at zero
+            std::atomic<std::int64_t> count = 0;
+        };
+
+        static constexpr int count_bits = 16;
+        static constexpr std::uint64_t count_mask = (std::uint64_t(1) << count_bits) - 1;
+
+        static_assert(sizeof(void *) == sizeof(std::uint64_t), "node addresses must fit in 48 bits");
+
+        // Address of the published node (or 0) and the number of pins on it
+        mutable std::atomic<std::uint64_t> word_ = 0;
+
+        static node *node_of(std::uint64_t word) noexcept {
+            return reinterpret_cast<node *>(word >> count_bits);
+        }
+
+        static std::uint64_t pins_of(std::uint64_t word) noexcept {
+            return word & count_mask;
+        }
+
+        static std::uint64_t publish(node *published) noexcept {
+            return static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(published)) << count_bits;
+        }
+
+        static node *make_node(shared_ptr<T> &&value);
+
+        // The node (null for an empty value) holds the same pointer with the same owner as `value`
+        static bool holds(const node *published, const shared_ptr<T> &value) noexcept;
+
+        // Pin the published node and return the word seen, including the new pin
+        std::uint64_t pin() const noexcept;
+
+        // Return a pin taken by pin(), given the word pin() saw: from the word if the node is still published,
+        // from the node otherwise
+        void unpin(std::uint64_t word) const noexcept;
+
+        // Move the pins of a node that has just been unpublished to the node itself, minus `own` pins held by the
+        // caller, and delete it if nobody holds a pin any more. Returns the value stored in the node
+        static shared_ptr<T> retire(std::uint64_t word, std::uint64_t own = 0);
+    };
+
+    template<typename T>
+    atomic_shared_ptr<T>::atomic_shared_ptr(shared_ptr<T> desired) : word_(publish(make_node(std::move(desired)))) {}
+
+    template<typename T>
+    atomic_shared_ptr<T>::~atomic_shared_ptr() {
+        delete node_of(word_.load(std::memory_order_relaxed));
+    }
+
+    template<typename T>
+    void atomic_shared_ptr<T>::operator=(shared_ptr<T> desired) {
+        store(std::move(desired));
+    }
+
+    template<typename T>
+    atomic_shared_ptr<T>::operator shared_ptr<T>() const {
+        return load();
+    }
+
+    template<typename T>
+    bool atomic_shared_ptr<T>::is_lock_free() const noexcept {
+        return word_.is_lock_free();
+    }
+
+    template<typename T>
+    shared_ptr<T> atomic_shared_ptr<T>::load(std::memory_order) const {
+        // Nothing to pin: an empty value can be returned right away
+        if (!node_of(word_.load())) {
+            return shared_ptr<T>();
+        }
+        std::uint64_t word = pin();
+        node *pinned = node_of(word);
+        shared_ptr<T> result = pinned ? pinned->value : shared_ptr<T>();
+        unpin(word);
+        return result;
+    }
+
+    template<typename T>
+    void atomic_shared_ptr<T>::store(shared_ptr<T> desired, std::memory_order) {
+        exchange(std::move(desired));
+    }
+
+    template<typename T>
+    shared_ptr<T> atomic_shared_ptr<T>::exchange(shared_ptr<T> desired, std::memory_order) {
+        return retire(word_.exchange(publish(make_node(std::move(desired)))));
+    }
+
+    template<typename T>
+    bool atomic_shared_ptr<T>::compare_exchange_strong(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                                       std::memory_order) {
+        node *replacement = make_node(std::move(desired));
+        while (true) {
+            std::uint64_t word = pin();
+            node *pinned = node_of(word);
+            if (!holds(pinned, expected)) {
+                expected = pinned ? pinned->value : shared_ptr<T>();
+                unpin(word);
+                // Never published, so no one else can see it
+                delete replacement;
+                return false;
+            }
+            // Replace the word as long as the same node is published, whatever its pins; our pin goes with it
+            std::uint64_t current = word;
+            while (node_of(current) == pinned) {
+                if (word_.compare_exchange_weak(current, publish(replacement))) {
+                    retire(current, 1);
+                    return true;
+                }
+            }
+            // Another writer got in between: compare against its value
+            unpin(word);
+        }
+    }
+
+    template<typename T>
+    bool atomic_shared_ptr<T>::compare_exchange_strong(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                                       std::memory_order success, std::memory_order) {
+        return compare_exchange_strong(expected, std::move(desired), success);
+    }
+
+    template<typename T>
+    bool atomic_shared_ptr<T>::compare_exchange_weak(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                                     std::memory_order order) {
+        return compare_exchange_strong(expected, std::move(desired), order);
+    }
+
+    template<typename T>
+    bool atomic_shared_ptr<T>::compare_exchange_weak(shared_ptr<T> &expected, shared_ptr<T> desired,
+                                                     std::memory_order success, std::memory_order) {
+        return compare_exchange_strong(expected, std::move(desired), success);
+    }
+
+    template<typename T>
+    typename atomic_shared_ptr<T>::node *atomic_shared_ptr<T>::make_node(shared_ptr<T> &&value) {
+        // An empty value is published as a null word
+        if (!value && !detail::shared_ptr_access::control_block(value)) {
+            return nullptr;
+        }
+        return new node{std::move(value)};
+    }
+
+    template<typename T>
+    bool atomic_shared_ptr<T>::holds(const node *published, const shared_ptr<T> &value) noexcept {
+        if (!published) {
+            return !value && !detail::shared_ptr_access::control_block(value);
+        }
+        return published->value.get() == value.get() && detail::shared_ptr_access::control_block(published->value) ==
+                                                         detail::shared_ptr_access::control_block(value);
+    }
+
+    template<typename T>
+    std::uint64_t atomic_shared_ptr<T>::pin() const noexcept {
+        return word_.fetch_add(1) + 1;
+    }
+
+    template<typename T>
+    void atomic_shared_ptr<T>::unpin(std::uint64_t word) const noexcept {
+        // Most of the time nothing has changed since the pin, and the first attempt succeeds
+        node *pinned = node_of(word);
+        while (node_of(word) == pinned && pins_of(word) != 0) {
+            if (word_.compare_exchange_weak(word, word - 1)) {
+                return;
+            }
+        }
+        // The node was unpublished and our pin moved to it. An empty value has no node and needs nothing
+        if (pinned && pinned->count.fetch_sub(1) == 1) {
+            delete pinned;
+        }
+    }
+
+    template<typename T>
+    shared_ptr<T> atomic_shared_ptr<T>::retire(std::uint64_t word, std::uint64_t own) {
+        node *retired = node_of(word);
+        if (!retired) {
+            return shared_ptr<T>();
+        }
+        auto moved = static_cast<std::int64_t>(pins_of(word) - own);
+        if (moved == 0) {
+            // Nobody else has pinned the node, so nobody can reach it any more: the value can be moved out
+            shared_ptr<T> result = std::move(retired->value);
+            delete retired;
+            return result;
+        }
+        // Readers may still be copying the value, so copy it before the node can go away
+        shared_ptr<T> result = retired->value;
+        if (retired->count.fetch_add(moved) == -moved) {
+            delete retired;
+        }
+        return result;
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_ATOMIC_SHARED_PTR
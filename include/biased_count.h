@@ -0,0 +1,324 @@
+#ifndef MP_CPP_HW1_BIASED_COUNT
+#define MP_CPP_HW1_BIASED_COUNT
+
+#include <atomic>  // std::atomic
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::int64_t
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    namespace detail::biased {
+        struct owner_record;
+    }  // namespace detail::biased
+
+    // Biased reference counting (Choi, Shull, Torrellas, 2018): thread-safe counting for objects that are mostly
+    // shared on the thread that created them. That thread, the owner, counts its references in a plain counter;
+    // the other threads use an atomic one. When the owner drops its last reference it merges the two counters, and
+    // from then on everybody uses the atomic one.
+    //
+    // A reference counted by the owner may be released on another thread, taking the atomic counter below zero.
+    // That thread then queues the block to the owner, which moves the difference from its own counter to the atomic
+    // one the next time it releases the object, creates an object with this policy, calls merge_pending() or exits;
+    // until then, the object stays alive even if nothing refers to it. Once the owner has exited, the thread that
+    // would queue the block merges the counters itself.
+    //
+    // use_count() is exact on the owner thread and an estimate on the others
+    struct biased_count {
+        class counts {
+        public:
+            counts() noexcept;
+
+            counts(const counts &) = delete;
+
+            counts &operator=(const counts &) = delete;
+
+            ~counts();
+
+            void add_ref() noexcept;
+
+            // Increments the use count unless the object is already destroyed. Returns true on success
+            bool try_add_ref() noexcept;
+
+            // Never true: release() always goes through retire()
+            [[nodiscard]] bool unique() const noexcept {
+                return false;
+            }
+
+            // Returns true if the block needs retire(): the last owner was dropped, or the counters have to be
+            // merged by the owner thread
+            bool release() noexcept;
+
+            void add_weak_ref() noexcept {
+                weak_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Returns true if the last weak reference was dropped
+            bool release_weak() noexcept {
+                return weak_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+
+            [[nodiscard]] std::size_t use_count() const noexcept;
+
+            // The thread that created the object
+            [[nodiscard]] detail::biased::owner_record *owner() const noexcept {
+                return owner_;
+            }
+
+            // Make up for the owner's references released on other threads out of the owner's count, merging the
+            // counters if nothing is left on the owner thread, and take the block off the owner's queue. Returns
+            // true if the object has to be destroyed. Called by the owner thread, or by any thread once it has
+            // exited
+            bool merge() noexcept;
+
+        private:
+            friend struct biased_count;
+
+            // The lower bits of shared_ are flags, the rest is a signed count
+            static constexpr std::int64_t merged = 1;
+            static constexpr std::int64_t queued = 2;
+            static constexpr std::int64_t one = 4;
+
+            detail::biased::owner_record *owner_;
+            // Written by the owner thread only, and read by others for use_count(): relaxed loads and stores of an
+            // atomic cost the same as plain ones
+            std::atomic<std::size_t> biased_ = 1;
+            std::atomic<std::int64_t> shared_ = 0;
+            std::atomic<std::size_t> weak_ = 1;
+
+            [[nodiscard]] bool owned_here() const noexcept;
+        };
+
+        // The next block in the owner's queue
+        using link = void *;
+
+        template<typename Block>
+        static void retire(Block *block) noexcept;
+
+        // Settle the counters of the blocks other threads have queued to the calling thread, destroying the objects
+        // nobody refers to any more
+        static void merge_pending() noexcept;
+    };
+
+    template<typename T>
+    using biased_shared_ptr = shared_ptr<T, biased_count>;
+
+    namespace detail::biased {
+        using block = control_block_base<biased_count>;
+
+        // One per thread that has created objects with biased_count, alive as long as the thread or any of them
+        struct owner_record {
+            // The thread itself and every object it owns
+            std::atomic<std::size_t> refs = 1;
+            // Stack of blocks to merge, linked through link(), or `closed` once the thread has exited
+            std::atomic<block *> queue = nullptr;
+        };
+
+        // Marks the queue of a thread that has exited; never a real block
+        inline block *closed() noexcept {
+            return reinterpret_cast<block *>(alignof(block));
+        }
+
+        inline thread_local owner_record *current = nullptr;
+
+        // Set while merge_pending() runs on this thread, so that objects created by the destructors it calls
+        // do not start another one
+        inline thread_local bool merging = false;
+
+        inline void release_record(owner_record *record) noexcept {
+            if (record->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete record;
+            }
+        }
+
+        inline void merge(block *queued) noexcept {
+            if (queued->counts().merge()) {
+                queued->reclaim();
+            }
+        }
+
+        // Merge every block in the stack starting at `head`
+        inline void merge_all(block *head) noexcept {
+            while (head) {
+                block *next = static_cast<block *>(head->link());
+                merge(head);
+                head = next;
+            }
+        }
+
+        // Closes the record of the thread when it exits: what is queued then is merged here, what comes later is
+        // merged by the threads that queue it
+        struct thread_exit {
+            ~thread_exit() {
+                owner_record *record = current;
+                biased_count::merge_pending();
+                current = nullptr;
+                merge_all(record->queue.exchange(closed(), std::memory_order_acq_rel));
+                release_record(record);
+            }
+        };
+
+        // The record of the calling thread, with a reference to it for a new object
+        inline owner_record *attach() {
+            if (!current) {
+                static thread_local thread_exit closer;
+                current = new owner_record;
+            } else if (current->queue.load(std::memory_order_relaxed) && !merging) {
+                // A safe point of the owner: nothing of ours is in the middle of an update
+                biased_count::merge_pending();
+            }
+            current->refs.fetch_add(1, std::memory_order_relaxed);
+            return current;
+        }
+
+        inline void enqueue(block *queued) noexcept {
+            owner_record *record = queued->counts().owner();
+            block *head = record->queue.load(std::memory_order_relaxed);
+            do {
+                if (head == closed()) {
+                    // The owner has exited: its count is final and no one else can be merging it
+                    std::atomic_thread_fence(std::memory_order_acquire);
+                    merge(queued);
+                    return;
+                }
+                queued->link() = head;
+            } while (!record->queue.compare_exchange_weak(head, queued, std::memory_order_acq_rel,
+                                                          std::memory_order_relaxed));
+        }
+    }  // namespace detail::biased
+
+    inline biased_count::counts::counts() noexcept : owner_(detail::biased::attach()) {}
+
+    inline biased_count::counts::~counts() {
+        detail::biased::release_record(owner_);
+    }
+
+    inline bool biased_count::counts::owned_here() const noexcept {
+        // Only the owner sets `merged` while it lives, so a relaxed load on its own thread sees the latest value
+        return owner_ == detail::biased::current && !(shared_.load(std::memory_order_relaxed) & merged);
+    }
+
+    inline void biased_count::counts::add_ref() noexcept {
+        if (owned_here()) {
+            biased_.store(biased_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        } else {
+            shared_.fetch_add(one, std::memory_order_relaxed);
+        }
+    }
+
+    inline bool biased_count::counts::try_add_ref() noexcept {
+        if (owned_here()) {
+            // Not merged yet, so the owner still holds a reference
+            biased_.store(biased_.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return true;
+        }
+        // Until the counters are merged the owner's count may still keep the object alive
+        std::int64_t current = shared_.load(std::memory_order_relaxed);
+        while (!(current & merged) || current >= one) {
+            if (shared_.compare_exchange_weak(current, current + one, std::memory_order_acq_rel,
+                                              std::memory_order_relaxed)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    inline bool biased_count::counts::release() noexcept {
+        std::int64_t shared = shared_.load(std::memory_order_relaxed);
+        if (owner_ == detail::biased::current && !(shared & merged)) {
+            std::size_t left = biased_.load(std::memory_order_relaxed) - 1;
+            biased_.store(left, std::memory_order_relaxed);
+            if (shared & queued) {
+                // Another thread has queued the block to us: retire() settles it now rather than at a safe point
+                return true;
+            }
+            if (left > 0) {
+                return false;
+            }
+            // The owner's share is gone: from now on the shared count is the whole count. If another thread has
+            // queued the block meanwhile, retire() merges it too
+            std::int64_t now = shared_.fetch_or(merged, std::memory_order_acq_rel) | merged;
+            return (now & queued) || now < one;
+        }
+        std::int64_t now = shared_.fetch_sub(one, std::memory_order_acq_rel) - one;
+        if (now & merged) {
+            // A queued block is destroyed by whoever takes it off the queue
+            return !(now & queued) && now < one;
+        }
+        if (now < 0 && !(now & queued)) {
+            // References counted by the owner were released here: the owner has to merge. One thread queues it
+            return !(shared_.fetch_or(queued, std::memory_order_acq_rel) & queued);
+        }
+        return false;
+    }
+
+    inline std::size_t biased_count::counts::use_count() const noexcept {
+        std::int64_t shared = shared_.load(std::memory_order_relaxed);
+        std::int64_t count = shared >> 2;
+        if (!(shared & merged)) {
+            count += static_cast<std::int64_t>(biased_.load(std::memory_order_relaxed));
+        }
+        return count > 0 ? static_cast<std::size_t>(count) : 0;
+    }
+
+    inline bool biased_count::counts::merge() noexcept {
+        std::int64_t current = shared_.load(std::memory_order_acquire);
+        if (!(current & merged)) {
+            std::size_t biased = biased_.load(std::memory_order_relaxed);
+            if (owner_->queue.load(std::memory_order_relaxed) == detail::biased::closed()) {
+                // The owner has exited and will not release its share: hand all of it over
+                current = shared_.fetch_add(static_cast<std::int64_t>(biased) * one, std::memory_order_acq_rel) +
+                          static_cast<std::int64_t>(biased) * one;
+                biased = 0;
+            } else {
+                // The other threads released this many of the owner's references: take them off the owner's count
+                // and off the queue, and keep counting the rest on the owner thread
+                std::int64_t moved;
+                do {
+                    moved = current < 0 ? -(current >> 2) : 0;
+                } while (!shared_.compare_exchange_weak(current, (current + moved * one) & ~queued,
+                                                        std::memory_order_acq_rel, std::memory_order_acquire));
+                biased -= static_cast<std::size_t>(moved);
+            }
+            biased_.store(biased, std::memory_order_relaxed);
+            if (biased > 0) {
+                return false;
+            }
+            // Nothing is counted on the owner thread any more, so the count cannot go below zero again
+            current = shared_.fetch_or(merged, std::memory_order_acq_rel) | merged;
+        }
+        // Off the queue, unless nobody refers to the object any more: then it is ours to destroy
+        while (current >= one) {
+            if (shared_.compare_exchange_weak(current, current & ~queued, std::memory_order_acq_rel,
+                                              std::memory_order_acquire)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    template<typename Block>
+    void biased_count::retire(Block *block) noexcept {
+        if (!(block->counts().shared_.load(std::memory_order_acquire) & counts::queued)) {
+            block->reclaim();
+        } else if (block->counts().owner() == detail::biased::current) {
+            merge_pending();
+        } else {
+            detail::biased::enqueue(block);
+        }
+    }
+
+    inline void biased_count::merge_pending() noexcept {
+        using namespace detail::biased;
+        if (!current || merging) {
+            return;
+        }
+        merging = true;
+        while (block *head = current->queue.exchange(nullptr, std::memory_order_acq_rel)) {
+            merge_all(head);
+        }
+        merging = false;
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_BIASED_COUNT
@@ -0,0 +1,200 @@
+#ifndef MP_CPP_HW1_BORROWED_PTR
+#define MP_CPP_HW1_BORROWED_PTR
+
+#include <concepts>  // std::convertible_to
+#include <cstddef>  // std::nullptr_t
+#include <stdexcept>  // std::logic_error
+#include <type_traits>  // std::is_array_v, std::true_type
+#include <utility>  // std::exchange, std::swap
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // A non-owning view of an object owned by shared_ptrs, to pass it down a call chain without touching the
+    // counts. Made from a shared_ptr for free, it is two pointers that are copied as they are, and to_shared()
+    // promotes it back to an owner where the object has to outlive the call. The shared_ptr it was made from (or
+    // another owner) must outlive the view, like with a reference.
+    //
+    // Debug builds check that: every view holds a weak reference to the control block, and using or promoting a
+    // view whose object is already destroyed throws std::logic_error. Release builds keep no reference, so there
+    // the view is trivially copyable. Its special members hence depend on NDEBUG: every translation unit of a
+    // program must be compiled with the same NDEBUG setting, or the class breaks the one definition rule
+    template<typename T, count_policy Policy = atomic_count>
+    class borrowed_ptr {
+        static_assert(!std::is_array_v<T>, "borrowed_ptr does not view arrays");
+
+    public:
+        using element_type = T;
+
+        // Constructs an empty borrowed_ptr
+        constexpr borrowed_ptr() noexcept = default;
+
+        // Constructs another empty borrowed_ptr
+        constexpr borrowed_ptr(std::nullptr_t) noexcept {}
+
+        // View the object of a shared_ptr
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        borrowed_ptr(const shared_ptr<Y, Policy> &ptr) noexcept
+                : obj_(ptr.get()), ctrl_(detail::shared_ptr_access::control_block(ptr)) {
+            acquire();
+        }
+
+        // A temporary shared_ptr would destroy the object before the view is used
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        borrowed_ptr(shared_ptr<Y, Policy> &&ptr) = delete;
+
+        // View the object of another view through a pointer to a base class
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        borrowed_ptr(const borrowed_ptr<Y, Policy> &other) noexcept : obj_(other.obj_), ctrl_(other.ctrl_) {
+            acquire();
+        }
+
+#ifndef NDEBUG
+        // Copy constructor
+        borrowed_ptr(const borrowed_ptr &other) noexcept : obj_(other.obj_), ctrl_(other.ctrl_) {
+            acquire();
+        }
+
+        // Move constructor: the weak reference goes along with the view
+        borrowed_ptr(borrowed_ptr &&other) noexcept
+                : obj_(std::exchange(other.obj_, nullptr)), ctrl_(std::exchange(other.ctrl_, nullptr)) {}
+
+        // Copy assignment operator
+        borrowed_ptr &operator=(const borrowed_ptr &other) noexcept;
+
+        // Move assignment operator
+        borrowed_ptr &operator=(borrowed_ptr &&other) noexcept;
+
+        // Destructor
+        ~borrowed_ptr() {
+            reset();
+        }
+#endif
+
+        // Dereference operator
+        T &operator*() const {
+            return *get();
+        }
+
+        // Member access operator
+        T *operator->() const {
+            return get();
+        }
+
+        // Boolean conversion operator
+        explicit operator bool() const noexcept {
+            return obj_ != nullptr;
+        }
+
+        // Get a raw pointer to the viewed object. Throws std::logic_error in debug builds if it is destroyed
+        T *get() const {
+            check();
+            return obj_;
+        }
+
+        // An owner of the viewed object, for when it has to outlive the view. Throws std::logic_error if the object
+        // is already destroyed, which only a debug build is sure to notice: a release build may find the block freed
+        shared_ptr<T, Policy> to_shared() const;
+
+        // Stop viewing the object
+        void reset() noexcept;
+
+        void swap(borrowed_ptr &other) noexcept {
+            std::swap(obj_, other.obj_);
+            std::swap(ctrl_, other.ctrl_);
+        }
+
+    private:
+        template<typename, count_policy>
+        friend class borrowed_ptr;
+
+        using block = detail::control_block_base<Policy>;
+
+        T *obj_ = nullptr;
+        block *ctrl_ = nullptr;
+
+        // Take the weak reference of a debug build
+        void acquire() noexcept {
+#ifndef NDEBUG
+            if (ctrl_) {
+                ctrl_->add_weak_ref();
+            }
+#endif
+        }
+
+        // Throw std::logic_error in debug builds if the owners of the object are gone
+        void check() const;
+    };
+
+#ifndef NDEBUG
+    template<typename T, count_policy Policy>
+    borrowed_ptr<T, Policy> &borrowed_ptr<T, Policy>::operator=(const borrowed_ptr &other) noexcept {
+        if (other.ctrl_) {
+            other.ctrl_->add_weak_ref();
+        }
+        block *old = std::exchange(ctrl_, other.ctrl_);
+        obj_ = other.obj_;
+        if (old) {
+            old->release_weak();
+        }
+        return *this;
+    }
+
+    template<typename T, count_policy Policy>
+    borrowed_ptr<T, Policy> &borrowed_ptr<T, Policy>::operator=(borrowed_ptr &&other) noexcept {
+        if (this != &other) {
+            reset();
+            obj_ = std::exchange(other.obj_, nullptr);
+            ctrl_ = std::exchange(other.ctrl_, nullptr);
+        }
+        return *this;
+    }
+#endif
+
+    template<typename T, count_policy Policy>
+    shared_ptr<T, Policy> borrowed_ptr<T, Policy>::to_shared() const {
+        if (!ctrl_) {
+            return shared_ptr<T, Policy>();
+        }
+        // Checking use_count() first and then incrementing would race with the last owner going in between
+        if (!ctrl_->try_add_ref()) {
+            throw std::logic_error("borrowed_ptr: the viewed object was destroyed");
+        }
+        return detail::shared_ptr_access::make<T, Policy>(obj_, ctrl_);
+    }
+
+    template<typename T, count_policy Policy>
+    void borrowed_ptr<T, Policy>::reset() noexcept {
+        obj_ = nullptr;
+#ifndef NDEBUG
+        if (block *old = std::exchange(ctrl_, nullptr)) {
+            old->release_weak();
+        }
+#else
+        ctrl_ = nullptr;
+#endif
+    }
+
+    template<typename T, count_policy Policy>
+    void borrowed_ptr<T, Policy>::check() const {
+#ifndef NDEBUG
+        if (ctrl_ && ctrl_->use_count() == 0) {
+            throw std::logic_error("borrowed_ptr: the viewed object was destroyed");
+        }
+#endif
+    }
+
+    // Two pointers, and a weak reference in debug builds
+    template<typename T, count_policy Policy>
+    struct is_trivially_relocatable<borrowed_ptr<T, Policy>> : std::true_type {};
+
+    template<typename T, count_policy Policy>
+    void swap(borrowed_ptr<T, Policy> &lhs, borrowed_ptr<T, Policy> &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_BORROWED_PTR
@@ -0,0 +1,277 @@
+#ifndef MP_CPP_HW1_COMPACT_SHARED_PTR
+#define MP_CPP_HW1_COMPACT_SHARED_PTR
+
+#include <concepts>  // std::convertible_to
+#include <cstddef>  // std::size_t, std::nullptr_t
+#include <cstdint>  // std::uint64_t, std::uintptr_t
+#include <stdexcept>  // std::invalid_argument
+#include <type_traits>  // std::is_array_v, std::true_type
+#include <utility>  // std::exchange, std::forward, std::move, std::swap
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // A shared_ptr in one machine word, for objects that lie right after their control block, like the ones
+    // make_shared creates. The word holds the address of the block in its upper 48 bits, which is all that x86-64
+    // and AArch64 use for user space, and the distance from the block to the object in the lower 16: the address
+    // of the object is worked out from them on every access. Copies, moves and reset() behave like those of
+    // shared_ptr, and the two convert to each other
+    template<typename T, count_policy Policy = atomic_count>
+    class compact_shared_ptr {
+        static_assert(!std::is_array_v<T>, "compact_shared_ptr does not manage arrays");
+        static_assert(sizeof(void *) == sizeof(std::uint64_t), "block addresses must fit in 48 bits");
+
+    public:
+        using element_type = T;
+
+        // The farthest the object may lie from the start of its control block
+        static constexpr std::size_t max_offset = 0xffff;
+
+        // Constructs an empty compact_shared_ptr
+        constexpr compact_shared_ptr() noexcept = default;
+
+        // Constructs another empty compact_shared_ptr
+        constexpr compact_shared_ptr(std::nullptr_t) noexcept {}
+
+        // Share ownership with a shared_ptr. Throws std::invalid_argument if the object does not lie within
+        // max_offset bytes after its control block, e.g. because the shared_ptr adopted it by pointer
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        explicit compact_shared_ptr(const shared_ptr<Y, Policy> &ptr);
+
+        // Same as above, but takes over the reference held by `ptr`, which is left empty unless this throws
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        explicit compact_shared_ptr(shared_ptr<Y, Policy> &&ptr);
+
+        // Copy constructor
+        compact_shared_ptr(const compact_shared_ptr &other) noexcept;
+
+        // Move constructor
+        compact_shared_ptr(compact_shared_ptr &&other) noexcept;
+
+        // Converting copy constructor from a pointer to a derived class. Throws std::invalid_argument if the base
+        // class subobject does not lie within max_offset bytes after the control block
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        compact_shared_ptr(const compact_shared_ptr<Y, Policy> &other);
+
+        // Converting move constructor
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        compact_shared_ptr(compact_shared_ptr<Y, Policy> &&other);
+
+        // Destructor
+        ~compact_shared_ptr();
+
+        // Copy assignment operator
+        compact_shared_ptr &operator=(const compact_shared_ptr &other) noexcept;
+
+        // Move assignment operator
+        compact_shared_ptr &operator=(compact_shared_ptr &&other) noexcept;
+
+        // The full handle, sharing ownership of the object
+        operator shared_ptr<T, Policy>() const & noexcept;
+
+        // Same as above, but hands over the reference of this pointer, which is left empty
+        operator shared_ptr<T, Policy>() && noexcept;
+
+        // Dereference operator
+        T &operator*() const noexcept {
+            return *get();
+        }
+
+        // Member access operator
+        T *operator->() const noexcept {
+            return get();
+        }
+
+        // Boolean conversion operator
+        explicit operator bool() const noexcept {
+            return word_ != 0;
+        }
+
+        // Get a raw pointer to the managed object
+        T *get() const noexcept {
+            return reinterpret_cast<T *>((word_ >> offset_bits) + (word_ & max_offset));
+        }
+
+        // Get the number of owners of the managed object
+        [[nodiscard]] std::size_t use_count() const noexcept;
+
+        // Release ownership of the managed object
+        void reset() noexcept;
+
+        void swap(compact_shared_ptr &other) noexcept {
+            std::swap(word_, other.word_);
+        }
+
+    private:
+        template<typename, count_policy>
+        friend class compact_shared_ptr;
+
+        using block = detail::control_block_base<Policy>;
+
+        static constexpr int offset_bits = 16;
+
+        // Empty, or the block address shifted up and the offset of the object from it
+        std::uint64_t word_ = 0;
+
+        block *control_block() const noexcept {
+            return reinterpret_cast<block *>(word_ >> offset_bits);
+        }
+
+        // The word for an object managed by a block, or 0 without a block. Throws std::invalid_argument if the
+        // object is too far from the block
+        static std::uint64_t pack(block *ctrl, const T *obj);
+    };
+
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires std::convertible_to<Y *, T *>
+    compact_shared_ptr<T, Policy>::compact_shared_ptr(const shared_ptr<Y, Policy> &ptr)
+            : word_(pack(detail::shared_ptr_access::control_block(ptr), ptr.get())) {
+        if (word_) {
+            control_block()->add_ref();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires std::convertible_to<Y *, T *>
+    compact_shared_ptr<T, Policy>::compact_shared_ptr(shared_ptr<Y, Policy> &&ptr)
+            : word_(pack(detail::shared_ptr_access::control_block(ptr), ptr.get())) {
+        if (word_) {
+            detail::shared_ptr_access::take(ptr)->moved();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    compact_shared_ptr<T, Policy>::compact_shared_ptr(const compact_shared_ptr &other) noexcept : word_(other.word_) {
+        if (word_) {
+            control_block()->add_ref();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    compact_shared_ptr<T, Policy>::compact_shared_ptr(compact_shared_ptr &&other) noexcept
+            : word_(std::exchange(other.word_, 0)) {
+        if (word_) {
+            control_block()->moved();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires std::convertible_to<Y *, T *>
+    compact_shared_ptr<T, Policy>::compact_shared_ptr(const compact_shared_ptr<Y, Policy> &other)
+            : word_(pack(other.control_block(), other.get())) {
+        if (word_) {
+            control_block()->add_ref();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires std::convertible_to<Y *, T *>
+    compact_shared_ptr<T, Policy>::compact_shared_ptr(compact_shared_ptr<Y, Policy> &&other)
+            : word_(pack(other.control_block(), other.get())) {
+        other.word_ = 0;
+        if (word_) {
+            control_block()->moved();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    compact_shared_ptr<T, Policy>::~compact_shared_ptr() {
+        reset();
+    }
+
+    template<typename T, count_policy Policy>
+    compact_shared_ptr<T, Policy> &compact_shared_ptr<T, Policy>::operator=(const compact_shared_ptr &other) noexcept {
+        // Take the new reference first: `other` may be owned by the object we are about to release
+        if (other.word_) {
+            other.control_block()->add_ref();
+        }
+        if (std::uint64_t old = std::exchange(word_, other.word_)) {
+            reinterpret_cast<block *>(old >> offset_bits)->release();
+        }
+        return *this;
+    }
+
+    template<typename T, count_policy Policy>
+    compact_shared_ptr<T, Policy> &compact_shared_ptr<T, Policy>::operator=(compact_shared_ptr &&other) noexcept {
+        if (this != &other) {
+            if (std::uint64_t old = std::exchange(word_, std::exchange(other.word_, 0))) {
+                reinterpret_cast<block *>(old >> offset_bits)->release();
+            }
+            if (word_) {
+                control_block()->moved();
+            }
+        }
+        return *this;
+    }
+
+    template<typename T, count_policy Policy>
+    compact_shared_ptr<T, Policy>::operator shared_ptr<T, Policy>() const & noexcept {
+        if (!word_) {
+            return shared_ptr<T, Policy>();
+        }
+        control_block()->add_ref();
+        return detail::shared_ptr_access::make<T, Policy>(get(), control_block());
+    }
+
+    template<typename T, count_policy Policy>
+    compact_shared_ptr<T, Policy>::operator shared_ptr<T, Policy>() && noexcept {
+        if (!word_) {
+            return shared_ptr<T, Policy>();
+        }
+        T *obj = get();
+        block *ctrl = control_block();
+        word_ = 0;
+        ctrl->moved();
+        return detail::shared_ptr_access::make<T, Policy>(obj, ctrl);
+    }
+
+    template<typename T, count_policy Policy>
+    std::size_t compact_shared_ptr<T, Policy>::use_count() const noexcept {
+        return word_ ? control_block()->use_count() : 0;
+    }
+
+    template<typename T, count_policy Policy>
+    void compact_shared_ptr<T, Policy>::reset() noexcept {
+        if (std::uint64_t old = std::exchange(word_, 0)) {
+            reinterpret_cast<block *>(old >> offset_bits)->release();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    std::uint64_t compact_shared_ptr<T, Policy>::pack(block *ctrl, const T *obj) {
+        if (!ctrl) {
+            return 0;
+        }
+        auto base = reinterpret_cast<std::uintptr_t>(ctrl);
+        auto address = reinterpret_cast<std::uintptr_t>(obj);
+        if (address < base || address - base > max_offset || (base >> (64 - offset_bits)) != 0) {
+            throw std::invalid_argument("compact_shared_ptr: the object is not stored with its control block");
+        }
+        return static_cast<std::uint64_t>(base) << offset_bits | (address - base);
+    }
+
+    // Pointers to a block and an offset in it
+    template<typename T, count_policy Policy>
+    struct is_trivially_relocatable<compact_shared_ptr<T, Policy>> : std::true_type {};
+
+    template<typename T, count_policy Policy>
+    void swap(compact_shared_ptr<T, Policy> &lhs, compact_shared_ptr<T, Policy> &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+
+    // make_shared returning the one-word handle. The object always lies right after its control block
+    template<typename T, count_policy Policy = atomic_count, typename... Args>
+    compact_shared_ptr<T, Policy> make_compact_shared(Args &&... args) {
+        return compact_shared_ptr<T, Policy>(make_shared<T, Policy>(std::forward<Args>(args)...));
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_COMPACT_SHARED_PTR
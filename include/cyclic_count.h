@@ -0,0 +1,431 @@
+#ifndef MP_CPP_HW1_CYCLIC_COUNT
+#define MP_CPP_HW1_CYCLIC_COUNT
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint8_t
+#include <deque>  // std::deque
+#include <new>  // std::bad_alloc
+#include <utility>  // std::exchange
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    namespace detail::cyclic {
+        class collector;
+    }  // namespace detail::cyclic
+
+    // Plain counting for pointers that never leave one thread, like local_count, with a collector for the cycles
+    // reference counting alone never frees: parents and children pointing at each other, observers registered with
+    // what they observe. Collection is opt-in per type: a type lists the pointers it holds in a
+    // `void trace(cyclic_tracer &visit) const` member calling visit(ptr) for each of them. Objects of other types
+    // are never seen as part of a cycle.
+    //
+    // When an owner goes and others remain, the object may just have become part of a garbage cycle, so it is
+    // buffered as a candidate root. collect_cycles() runs trial deletion (Bacon and Rajan, 2001) from the buffered
+    // roots: it subtracts the references the objects reachable from them hold to each other, and the objects left
+    // without references are garbage. Every thread has its own buffer; objects must stay on the thread that made them
+    struct cyclic_count {
+        class counts {
+        public:
+            void add_ref() noexcept {
+                ++use_count_;
+            }
+
+            // Increments the use count unless the object is destroyed or being collected. Returns true on success
+            bool try_add_ref() noexcept;
+
+            // Never true: release() goes through retire()
+            [[nodiscard]] bool unique() const noexcept {
+                return false;
+            }
+
+            // Returns true if the block needs retire(): the last owner went, or the object became a candidate root.
+            // The releases of a dead object come from the destructors of garbage and change nothing
+            bool release() noexcept;
+
+            void add_weak_ref() noexcept {
+                ++weak_count_;
+            }
+
+            bool release_weak() noexcept {
+                return --weak_count_ == 0;
+            }
+
+            [[nodiscard]] std::size_t use_count() const noexcept {
+                return color_ == color::dead ? 0 : use_count_;
+            }
+
+        private:
+            friend class detail::cyclic::collector;
+
+            // The colors of trial deletion. Black objects are in use, purple ones are candidate roots, gray and
+            // white ones are being examined by the collector, and dead ones are garbage it is destroying
+            enum class color : std::uint8_t {
+                black,
+                purple,
+                gray,
+                white,
+                dead
+            };
+
+            std::size_t use_count_ = 1;
+            std::size_t weak_count_ = 1;
+            // The next block on the work list of the collector or in the garbage it destroys: the lists are linked
+            // through the blocks, so that a collection never allocates. A block type cannot be named before the
+            // policy is complete, so the collector casts the pointer back
+            void *next_ = nullptr;
+            color color_ = color::black;
+            // In the candidate buffer, which holds a weak reference to the block
+            bool buffered_ = false;
+            // On the work list of the collector
+            bool queued_ = false;
+            // The object does not list its pointers, so it cannot be part of a cycle the collector can see
+            bool acyclic_ = false;
+        };
+
+        template<typename Block>
+        static void retire(Block *block) noexcept;
+    };
+
+    template<typename T>
+    using cyclic_shared_ptr = shared_ptr<T, cyclic_count>;
+
+    using cyclic_tracer = tracer<cyclic_count>;
+
+    // The counters of the collector of the calling thread
+    struct cycle_statistics {
+        // Candidate roots waiting in the buffer
+        std::size_t buffered_roots;
+        // Objects examined by trial deletion and objects destroyed as garbage so far
+        std::size_t visited_objects;
+        std::size_t collected_objects;
+    };
+
+    // No limit on the work collect_cycles() does
+    inline constexpr std::size_t unlimited_budget = static_cast<std::size_t>(-1);
+
+    // Destroy the garbage cycles reachable from the candidate roots buffered on the calling thread. Roots are taken
+    // from the buffer oldest first until `budget` objects have been examined, so the pause is bounded by the budget
+    // plus the objects reachable from the last root taken; the other roots wait for the next call.
+    // Returns the number of objects destroyed
+    std::size_t collect_cycles(std::size_t budget = unlimited_budget) noexcept;
+
+    [[nodiscard]] cycle_statistics cycle_stats() noexcept;
+
+    namespace detail::cyclic {
+        using block = control_block_base<cyclic_count>;
+
+        // Calls a function with the control block of every pointer an object lists
+        template<typename Visit>
+        class edge_visitor final : public cyclic_tracer {
+        public:
+            explicit edge_visitor(Visit &visit) noexcept : visit_(visit) {}
+
+        private:
+            Visit &visit_;
+
+            void visit(block *target) noexcept override {
+                visit_(target);
+            }
+        };
+
+        // Trial deletion over the candidate roots of one thread. The graph is walked with work lists linked through
+        // the control blocks, so long chains of objects do not overflow the call stack and a collection needs no
+        // memory it could fail to get
+        class collector {
+        public:
+            collector() = default;
+
+            collector(const collector &) = delete;
+
+            collector &operator=(const collector &) = delete;
+
+            // Drops the roots still buffered when the thread exits: their cycles are never collected
+            ~collector();
+
+            // Add a candidate root. If the buffer cannot grow, the root is left out until a later release buffers it
+            void buffer(block *root) noexcept;
+
+            std::size_t collect(std::size_t budget) noexcept;
+
+            [[nodiscard]] cycle_statistics stats() const noexcept {
+                return {roots_.size(), visited_, collected_};
+            }
+
+        private:
+            using color = cyclic_count::counts::color;
+
+            // A singly linked list of blocks, through their next_
+            struct block_list {
+                block *head = nullptr;
+                block *tail = nullptr;
+                std::size_t size = 0;
+            };
+
+            std::deque<block *> roots_;
+            // The blocks a traversal has still to look at, most recent first
+            block *work_ = nullptr;
+            std::size_t visited_ = 0;
+            std::size_t collected_ = 0;
+            // Set while collect() runs: the destructors of garbage objects may not start another collection
+            bool collecting_ = false;
+
+            static cyclic_count::counts &counts(block *node) noexcept {
+                return node->counts();
+            }
+
+            static block *next(block *node) noexcept {
+                return static_cast<block *>(counts(node).next_);
+            }
+
+            void push(block *node) noexcept {
+                counts(node).next_ = std::exchange(work_, node);
+                counts(node).queued_ = true;
+            }
+
+            block *pop() noexcept {
+                block *node = std::exchange(work_, next(work_));
+                counts(node).queued_ = false;
+                return node;
+            }
+
+            // Call visit(target) for every pointer the object of `node` lists. Returns false if it lists none
+            template<typename Visit>
+            static bool for_each_edge(block *node, Visit visit) noexcept {
+                edge_visitor<Visit> visitor(visit);
+                return node->trace(visitor);
+            }
+
+            // Color everything reachable from the root gray, subtracting the references between these objects
+            void mark_gray(block *root) noexcept;
+
+            // Color the gray objects reachable from the root white if nothing outside refers to them any more,
+            // restoring the objects that are still referenced and everything they reach
+            void scan(block *root) noexcept;
+
+            // Color a gray or white object black and queue it to restore the references it holds
+            void scan_black(block *node) noexcept;
+
+            // Color the white objects reachable from the root dead and add them to `garbage`
+            static void collect_white(block *root, block_list &garbage) noexcept;
+
+            // Destroy the objects of a garbage set
+            static void free_garbage(const block_list &garbage) noexcept;
+        };
+
+        inline thread_local collector thread_collector;
+
+        // Set when the collector of the thread has been destroyed: objects released later are no longer buffered
+        inline thread_local bool exited = false;
+
+        inline collector::~collector() {
+            exited = true;
+            for (block *root: roots_) {
+                counts(root).buffered_ = false;
+                root->release_weak();
+            }
+        }
+
+        inline void collector::buffer(block *root) noexcept {
+            try {
+                roots_.push_back(root);
+            } catch (const std::bad_alloc &) {
+                // Black again, so that the next release of the object tries to buffer it once more
+                counts(root).color_ = color::black;
+                return;
+            }
+            counts(root).buffered_ = true;
+            root->add_weak_ref();
+        }
+
+        inline std::size_t collector::collect(std::size_t budget) noexcept {
+            if (collecting_) {
+                return 0;
+            }
+            collecting_ = true;
+            // The roots taken stay at the front of the buffer until the garbage is destroyed. Out of the buffer as
+            // far as their flag goes, so that a release during this collection can buffer them again
+            std::size_t taken = 0;
+            std::size_t start = visited_;
+            while (taken < roots_.size() && visited_ - start < budget) {
+                block *root = roots_[taken++];
+                counts(root).buffered_ = false;
+                if (counts(root).color_ == color::purple && counts(root).use_count_ > 0) {
+                    mark_gray(root);
+                }
+            }
+            for (std::size_t i = 0; i < taken; ++i) {
+                scan(roots_[i]);
+            }
+            block_list garbage;
+            for (std::size_t i = 0; i < taken; ++i) {
+                collect_white(roots_[i], garbage);
+            }
+            free_garbage(garbage);
+            for (; taken > 0; --taken) {
+                block *root = roots_.front();
+                roots_.pop_front();
+                root->release_weak();
+            }
+            collected_ += garbage.size;
+            collecting_ = false;
+            return garbage.size;
+        }
+
+        inline void collector::mark_gray(block *root) noexcept {
+            // An object is queued once, when it turns gray
+            auto gray = [this](block *node) {
+                counts(node).color_ = color::gray;
+                ++visited_;
+                push(node);
+            };
+            gray(root);
+            while (work_) {
+                block *node = pop();
+                bool listed = for_each_edge(node, [&](block *target) {
+                    --counts(target).use_count_;
+                    if (counts(target).color_ != color::gray) {
+                        gray(target);
+                    }
+                });
+                if (!listed) {
+                    counts(node).acyclic_ = true;
+                }
+            }
+        }
+
+        inline void collector::scan(block *root) noexcept {
+            // A queued object is gray if it is still to be examined and black if the references it holds are still
+            // to be restored. One that turns black while queued for examination is restored instead
+            if (counts(root).color_ != color::gray) {
+                return;
+            }
+            push(root);
+            while (work_) {
+                block *node = pop();
+                if (counts(node).color_ == color::black) {
+                    for_each_edge(node, [this](block *target) {
+                        ++counts(target).use_count_;
+                        if (counts(target).color_ != color::black) {
+                            scan_black(target);
+                        }
+                    });
+                } else if (counts(node).use_count_ > 0) {
+                    scan_black(node);
+                } else {
+                    counts(node).color_ = color::white;
+                    for_each_edge(node, [this](block *target) {
+                        if (counts(target).color_ == color::gray && !counts(target).queued_) {
+                            push(target);
+                        }
+                    });
+                }
+            }
+        }
+
+        inline void collector::scan_black(block *node) noexcept {
+            counts(node).color_ = color::black;
+            if (!counts(node).queued_) {
+                push(node);
+            }
+        }
+
+        inline void collector::collect_white(block *root, block_list &garbage) noexcept {
+            auto kill = [&garbage](block *node) {
+                counts(node).color_ = color::dead;
+                counts(node).next_ = nullptr;
+                if (garbage.tail) {
+                    counts(garbage.tail).next_ = node;
+                } else {
+                    garbage.head = node;
+                }
+                garbage.tail = node;
+                ++garbage.size;
+            };
+            if (counts(root).color_ != color::white) {
+                return;
+            }
+            // The garbage list doubles as the queue of the walk: the objects after `node` are still to be looked at
+            kill(root);
+            for (block *node = root; node; node = next(node)) {
+                for_each_edge(node, [&](block *target) {
+                    if (counts(target).color_ == color::white) {
+                        kill(target);
+                    }
+                });
+            }
+        }
+
+        inline void collector::free_garbage(const block_list &garbage) noexcept {
+            // The destructors release every pointer the objects hold. The references to live objects were
+            // subtracted by mark_gray and are put back for them; the ones between dead objects stay subtracted and
+            // their releases are ignored. Every block is kept until all the objects are destroyed
+            for (block *node = garbage.head; node; node = next(node)) {
+                for_each_edge(node, [](block *target) {
+                    if (counts(target).color_ != color::dead) {
+                        ++counts(target).use_count_;
+                    }
+                });
+                node->add_weak_ref();
+            }
+            for (block *node = garbage.head; node; node = next(node)) {
+                node->reclaim();
+            }
+            for (block *node = garbage.head; node;) {
+                block *following = next(node);
+                counts(node).use_count_ = 0;
+                node->release_weak();
+                node = following;
+            }
+        }
+    }  // namespace detail::cyclic
+
+    inline bool cyclic_count::counts::try_add_ref() noexcept {
+        if (use_count_ == 0 || color_ == color::dead) {
+            return false;
+        }
+        ++use_count_;
+        return true;
+    }
+
+    inline bool cyclic_count::counts::release() noexcept {
+        // The references between dead objects were subtracted by the collector already
+        if (color_ == color::dead) {
+            return false;
+        }
+        if (--use_count_ == 0) {
+            return true;
+        }
+        if (color_ == color::black && !acyclic_) {
+            // What is left may be referenced only by a cycle
+            color_ = color::purple;
+            return !buffered_;
+        }
+        return false;
+    }
+
+    template<typename Block>
+    void cyclic_count::retire(Block *block) noexcept {
+        if (block->use_count() == 0) {
+            block->reclaim();
+        } else if (!detail::cyclic::exited) {
+            detail::cyclic::thread_collector.buffer(block);
+        }
+    }
+
+    inline std::size_t collect_cycles(std::size_t budget) noexcept {
+        if (detail::cyclic::exited) {
+            return 0;
+        }
+        return detail::cyclic::thread_collector.collect(budget);
+    }
+
+    inline cycle_statistics cycle_stats() noexcept {
+        if (detail::cyclic::exited) {
+            return {};
+        }
+        return detail::cyclic::thread_collector.stats();
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_CYCLIC_COUNT
@@ -0,0 +1,182 @@
+#ifndef MP_CPP_HW1_DEFERRED_COUNT
+#define MP_CPP_HW1_DEFERRED_COUNT
+
+#include <atomic>  // std::atomic
+#include <chrono>  // std::chrono::microseconds
+#include <condition_variable>  // std::condition_variable_any
+#include <cstddef>  // std::size_t
+#include <mutex>  // std::mutex, std::unique_lock
+#include <stop_token>  // std::stop_token
+#include <thread>  // std::jthread
+#include <utility>  // std::exchange
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // Thread-safe counting like atomic_count, but the last owner does not destroy the object: the control block is
+    // pushed onto a lock-free queue instead, and the object is destroyed later, in a batch, by drain() or by a
+    // reclaimer_thread. This moves the destructor cascades of big object graphs off the threads that happen to drop
+    // them. weak_ptrs to a queued object have already expired, and objects still queued when the program ends are
+    // never destroyed.
+    //
+    // The queue is bounded by deferred_memory_limit(): the owner that pushes it over the limit drains it itself
+    struct deferred_count {
+        using counts = atomic_count::counts;
+
+        // The next block in the queue
+        using link = void *;
+
+        template<typename Block>
+        static void retire(Block *block) noexcept;
+    };
+
+    template<typename T>
+    using deferred_shared_ptr = shared_ptr<T, deferred_count>;
+
+    // A snapshot of the deferred reclamation counters
+    struct deferred_statistics {
+        // Blocks waiting in the queue, and the memory they hold
+        std::size_t queued_blocks;
+        std::size_t queued_bytes;
+        // Blocks reclaimed so far, and the calls to drain() that found something to reclaim
+        std::size_t reclaimed_blocks;
+        std::size_t drains;
+    };
+
+    // Destroy every object queued so far, including the ones their destructors queue, on the calling thread.
+    // Returns the number of blocks reclaimed. Can be called from any thread, at any time
+    std::size_t drain() noexcept;
+
+    [[nodiscard]] deferred_statistics deferred_stats() noexcept;
+
+    // The most memory the queue may hold before the owner pushing to it drains it. 64 MiB by default
+    [[nodiscard]] std::size_t deferred_memory_limit() noexcept;
+
+    void set_deferred_memory_limit(std::size_t bytes) noexcept;
+
+    // A background thread calling drain() every `period` while it exists. Drains what is left when destroyed
+    class reclaimer_thread {
+    public:
+        explicit reclaimer_thread(std::chrono::microseconds period = std::chrono::milliseconds(1));
+
+        reclaimer_thread(const reclaimer_thread &) = delete;
+
+        reclaimer_thread &operator=(const reclaimer_thread &) = delete;
+
+        ~reclaimer_thread();
+
+    private:
+        std::mutex mutex_;
+        std::condition_variable_any wakeup_;
+        std::jthread thread_;
+    };
+
+    namespace detail::deferred {
+        using block = control_block_base<deferred_count>;
+
+        // Constant-initialised, so it can be used by objects destroyed at any point of the program
+        struct queue_state {
+            // Top of a stack of blocks linked through link(); drain() takes the whole stack at once
+            std::atomic<block *> head = nullptr;
+            std::atomic<std::size_t> queued_blocks = 0;
+            std::atomic<std::size_t> queued_bytes = 0;
+            std::atomic<std::size_t> reclaimed_blocks = 0;
+            std::atomic<std::size_t> drains = 0;
+            std::atomic<std::size_t> memory_limit = std::size_t(64) << 20;
+        };
+
+        inline queue_state queue;
+
+        // Set while this thread is in drain(): blocks queued by the destructors it runs are picked up by its loop
+        inline thread_local bool draining = false;
+
+        inline block *next_of(block *queued) noexcept {
+            return static_cast<block *>(queued->link());
+        }
+
+        inline void push(block *retired) noexcept {
+            std::size_t bytes = retired->footprint();
+            queue.queued_blocks.fetch_add(1, std::memory_order_relaxed);
+            std::size_t queued = queue.queued_bytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+            block *head = queue.head.load(std::memory_order_relaxed);
+            do {
+                retired->link() = head;
+            } while (!queue.head.compare_exchange_weak(head, retired, std::memory_order_release,
+                                                       std::memory_order_relaxed));
+            if (queued > queue.memory_limit.load(std::memory_order_relaxed) && !draining) {
+                drain();
+            }
+        }
+    }  // namespace detail::deferred
+
+    template<typename Block>
+    void deferred_count::retire(Block *block) noexcept {
+        detail::deferred::push(block);
+    }
+
+    inline std::size_t drain() noexcept {
+        using namespace detail::deferred;
+        bool outer = !std::exchange(draining, true);
+        std::size_t reclaimed = 0;
+        while (block *batch = queue.head.exchange(nullptr, std::memory_order_acquire)) {
+            // The stack holds the newest block first: reverse it to destroy objects in the order they were dropped
+            block *oldest = nullptr;
+            while (batch) {
+                block *next = next_of(batch);
+                batch->link() = oldest;
+                oldest = batch;
+                batch = next;
+            }
+            while (oldest) {
+                block *next = next_of(oldest);
+                std::size_t bytes = oldest->footprint();
+                oldest->reclaim();
+                queue.queued_bytes.fetch_sub(bytes, std::memory_order_relaxed);
+                queue.queued_blocks.fetch_sub(1, std::memory_order_relaxed);
+                ++reclaimed;
+                oldest = next;
+            }
+        }
+        if (outer) {
+            draining = false;
+        }
+        if (reclaimed > 0) {
+            queue.reclaimed_blocks.fetch_add(reclaimed, std::memory_order_relaxed);
+            queue.drains.fetch_add(1, std::memory_order_relaxed);
+        }
+        return reclaimed;
+    }
+
+    inline deferred_statistics deferred_stats() noexcept {
+        using detail::deferred::queue;
+        return {queue.queued_blocks.load(std::memory_order_relaxed), queue.queued_bytes.load(std::memory_order_relaxed),
+                queue.reclaimed_blocks.load(std::memory_order_relaxed), queue.drains.load(std::memory_order_relaxed)};
+    }
+
+    inline std::size_t deferred_memory_limit() noexcept {
+        return detail::deferred::queue.memory_limit.load(std::memory_order_relaxed);
+    }
+
+    inline void set_deferred_memory_limit(std::size_t bytes) noexcept {
+        detail::deferred::queue.memory_limit.store(bytes, std::memory_order_relaxed);
+    }
+
+    inline reclaimer_thread::reclaimer_thread(std::chrono::microseconds period)
+            : thread_([this, period](std::stop_token stop) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        while (!stop.stop_requested()) {
+            lock.unlock();
+            drain();
+            lock.lock();
+            wakeup_.wait_for(lock, stop, period, [] { return false; });
+        }
+    }) {}
+
+    inline reclaimer_thread::~reclaimer_thread() {
+        thread_.request_stop();
+        thread_.join();
+        drain();
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_DEFERRED_COUNT
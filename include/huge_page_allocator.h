@@ -0,0 +1,191 @@
+#ifndef MP_CPP_HW1_HUGE_PAGE_ALLOCATOR
+#define MP_CPP_HW1_HUGE_PAGE_ALLOCATOR
+
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uintptr_t
+#include <memory>  // std::allocator
+#include <new>  // std::bad_alloc, std::align_val_t
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>  // MPOL_BIND, MPOL_INTERLEAVE
+#include <sys/mman.h>  // mmap, munmap, madvise
+#include <sys/syscall.h>  // SYS_mbind
+#include <unistd.h>  // syscall
+#endif
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // Which NUMA nodes the pages of a buffer are placed on
+    class numa_placement {
+    public:
+        // Wherever the thread touching a page first runs, the default of the system
+        static constexpr numa_placement first_touch() noexcept {
+            return numa_placement(kind::first_touch, 0);
+        }
+
+        // Pages spread over all the nodes in turn, for buffers read by threads on every node
+        static constexpr numa_placement interleaved() noexcept {
+            return numa_placement(kind::interleaved, 0);
+        }
+
+        // Pages taken from the given node only
+        static constexpr numa_placement on_node(int node) noexcept {
+            return numa_placement(kind::bound, node);
+        }
+
+        // Apply the placement to `size` bytes of fresh mappings at `memory`. Returns false if the system refused,
+        // in which case the pages simply go where they would without a placement
+        bool apply(void *memory, std::size_t size) const noexcept;
+
+    private:
+        enum class kind {
+            first_touch,
+            interleaved,
+            bound
+        };
+
+        kind kind_;
+        int node_;
+
+        constexpr numa_placement(kind placement, int node) noexcept : kind_(placement), node_(node) {}
+    };
+
+    namespace detail::huge_pages {
+        constexpr std::size_t page_size = std::size_t(2) << 20;
+
+        constexpr std::size_t round_up(std::size_t bytes) noexcept {
+            return (bytes + page_size - 1) / page_size * page_size;
+        }
+
+        // Map `size` bytes (a multiple of page_size) aligned to page_size and ask for transparent huge pages
+        inline void *map(std::size_t size, const numa_placement &placement) {
+#if defined(__linux__)
+            // Map one page more than needed and cut the ends off to get the alignment
+            void *mapping = ::mmap(nullptr, size + page_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS,
+                                   -1, 0);
+            if (mapping == MAP_FAILED) {
+                throw std::bad_alloc();
+            }
+            auto begin = reinterpret_cast<std::uintptr_t>(mapping);
+            auto aligned = (begin + page_size - 1) / page_size * page_size;
+            if (aligned > begin) {
+                ::munmap(mapping, aligned - begin);
+            }
+            if (std::size_t tail = begin + page_size - aligned) {
+                ::munmap(reinterpret_cast<void *>(aligned + size), tail);
+            }
+            void *memory = reinterpret_cast<void *>(aligned);
+            // Both are hints: without them the buffer still works with 4 KiB pages placed by first touch
+            ::madvise(memory, size, MADV_HUGEPAGE);
+            placement.apply(memory, size);
+            return memory;
+#else
+            (void) placement;
+            return ::operator new(size, std::align_val_t(page_size));
+#endif
+        }
+
+        inline void unmap(void *memory, std::size_t size) noexcept {
+#if defined(__linux__)
+            ::munmap(memory, size);
+#else
+            ::operator delete(memory, size, std::align_val_t(page_size));
+#endif
+        }
+    }  // namespace detail::huge_pages
+
+    inline bool numa_placement::apply(void *memory, std::size_t size) const noexcept {
+#if defined(__linux__) && defined(SYS_mbind)
+        if (kind_ == kind::first_touch) {
+            return true;
+        }
+        constexpr unsigned long mask_bits = sizeof(unsigned long) * 8;
+        unsigned long nodes = ~0ul;
+        int mode = MPOL_INTERLEAVE;
+        if (kind_ == kind::bound) {
+            if (node_ < 0 || static_cast<unsigned long>(node_) >= mask_bits) {
+                return false;
+            }
+            nodes = 1ul << node_;
+            mode = MPOL_BIND;
+        }
+        // Called directly rather than through libnuma, so that nothing extra has to be linked. The kernel drops
+        // the nodes that do not exist from the mask, and fails with ENOSYS where NUMA is not supported at all.
+        // It reads one bit less than maxnode, hence the + 1
+        return ::syscall(SYS_mbind, memory, size, mode, &nodes, mask_bits + 1, 0) == 0;
+#else
+        (void) memory;
+        (void) size;
+        return kind_ == kind::first_touch;
+#endif
+    }
+
+    // Allocator for big buffers: requests of at least one huge page (2 MiB) get their own mapping aligned to 2 MiB
+    // with transparent huge pages requested, placed on NUMA nodes as asked. Smaller requests, such as the control
+    // blocks of shared_ptrs adopting a pointer, come from std::allocator
+    template<typename T>
+    class huge_page_allocator {
+    public:
+        using value_type = T;
+
+        huge_page_allocator() noexcept = default;
+
+        explicit huge_page_allocator(numa_placement placement) noexcept : placement_(placement) {}
+
+        template<typename U>
+        huge_page_allocator(const huge_page_allocator<U> &other) noexcept : placement_(other.placement()) {}
+
+        T *allocate(std::size_t n) {
+            if (mapped(n)) {
+                return static_cast<T *>(detail::huge_pages::map(detail::huge_pages::round_up(n * sizeof(T)),
+                                                               placement_));
+            }
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T *ptr, std::size_t n) noexcept {
+            if (mapped(n)) {
+                detail::huge_pages::unmap(ptr, detail::huge_pages::round_up(n * sizeof(T)));
+            } else {
+                std::allocator<T>().deallocate(ptr, n);
+            }
+        }
+
+        [[nodiscard]] numa_placement placement() const noexcept {
+            return placement_;
+        }
+
+        // Any instance can free memory of any other: the placement only matters when memory is allocated
+        template<typename U>
+        bool operator==(const huge_page_allocator<U> &) const noexcept {
+            return true;
+        }
+
+    private:
+        numa_placement placement_ = numa_placement::first_touch();
+
+        static bool mapped(std::size_t n) noexcept {
+            return n >= detail::huge_pages::page_size / sizeof(T) && alignof(T) <= detail::huge_pages::page_size;
+        }
+    };
+
+    // make_shared taking its block from huge pages placed as asked. Meant for big arrays, e.g.
+    // make_huge_shared<double[]>(numa_placement::interleaved(), n)
+    template<typename T, count_policy Policy = atomic_count, typename... Args>
+    auto make_huge_shared(numa_placement placement, Args &&... args) {
+        return allocate_shared<T, Policy>(
+                huge_page_allocator<std::remove_cv_t<std::remove_all_extents_t<T>>>(placement),
+                std::forward<Args>(args)...);
+    }
+
+    // Same as above, with the elements left default-initialised for the caller to fill
+    template<typename T, count_policy Policy = atomic_count, typename... Args>
+    auto make_huge_shared_for_overwrite(numa_placement placement, Args &&... args) {
+        return allocate_shared_for_overwrite<T, Policy>(
+                huge_page_allocator<std::remove_cv_t<std::remove_all_extents_t<T>>>(placement),
+                std::forward<Args>(args)...);
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_HUGE_PAGE_ALLOCATOR
@@ -0,0 +1,367 @@
+#ifndef MP_CPP_HW1_INSTRUMENTATION
+#define MP_CPP_HW1_INSTRUMENTATION
+
+#include <algorithm>  // std::max
+#include <atomic>  // std::atomic
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::int64_t, std::uint32_t, std::uint64_t
+#include <map>  // std::map
+#include <mutex>  // std::mutex, std::lock_guard
+#include <source_location>  // std::source_location
+#include <string>  // std::string, std::to_string
+#include <string_view>  // std::string_view
+#include <tuple>  // std::tie
+#include <utility>  // std::move
+#include <vector>  // std::vector
+
+// Counters of the control blocks and the copies of shared_ptrs, per type of managed object. shared_ptr.h feeds them
+// when MP_CPP_HW1_INSTRUMENT is defined, and compiles the hooks out otherwise. The macro changes the layout of the
+// control blocks, so it has to be the same in the whole program.
+//
+// Every thread counts in its own shard, so the counting takes no locks and shares no cache lines; a snapshot sums
+// the shards. The counts of a thread that has exited are kept in a shared shard
+
+namespace smart_pointer::instrumentation {
+    // The counters of one type of managed object, summed over all threads
+    struct type_counters {
+        std::string type;
+        // Control blocks alive, and the memory they hold
+        std::int64_t live_blocks = 0;
+        std::int64_t live_bytes = 0;
+        // Control blocks created, and owners added to existing ones and moved between shared_ptrs so far
+        std::uint64_t allocations = 0;
+        std::uint64_t copies = 0;
+        std::uint64_t moves = 0;
+        // The highest use count a copy has produced
+        std::uint64_t peak_use_count = 0;
+    };
+
+    // The make_shared calls made from one place with a call_site argument
+    struct call_site_counters {
+        std::string file;
+        std::string function;
+        std::uint32_t line = 0;
+        std::uint64_t allocations = 0;
+        std::uint64_t bytes = 0;
+    };
+
+    struct snapshot {
+        // In the order the types were first counted; only the types counted so far
+        std::vector<type_counters> types;
+        std::vector<call_site_counters> call_sites;
+
+        // The counters of a type named as type_name() names it, or nullptr if it has never been counted
+        [[nodiscard]] const type_counters *find(std::string_view type) const noexcept;
+
+        // {"types": [{"type": ..., "live_blocks": ..., ...}, ...], "call_sites": [{"file": ..., ...}, ...]}
+        [[nodiscard]] std::string to_json() const;
+    };
+
+    // Sum the counters of all threads. Counts being updated by other threads meanwhile may be missed
+    [[nodiscard]] snapshot take_snapshot();
+
+    // The readable name of T the counters are reported under, e.g. "Dog" or "smart_pointer::shared_ptr<Animal> []"
+    template<typename T>
+    constexpr std::string_view type_name() noexcept {
+        // GCC spells it "... [with T = Dog; ...]", Clang "... [T = Dog]"
+        std::string_view name = std::source_location::current().function_name();
+        std::size_t begin = name.find("T = ");
+        if (begin == std::string_view::npos) {
+            return name;
+        }
+        begin += 4;
+        std::size_t end = name.find(';', begin);
+        if (end == std::string_view::npos) {
+            end = name.rfind(']');
+        }
+        return name.substr(begin, end - begin);
+    }
+
+    namespace detail {
+        // Types beyond this number are counted together under "(other types)"
+        constexpr std::uint32_t max_types = 512;
+
+        // The counters of one type in one shard. Only the thread owning the shard writes them, so an increment is
+        // a relaxed load and store, not a read-modify-write
+        struct type_slot {
+            std::atomic<std::int64_t> live_blocks = 0;
+            std::atomic<std::int64_t> live_bytes = 0;
+            std::atomic<std::uint64_t> allocations = 0;
+            std::atomic<std::uint64_t> copies = 0;
+            std::atomic<std::uint64_t> moves = 0;
+            std::atomic<std::uint64_t> peak_use_count = 0;
+        };
+
+        struct site_key {
+            std::string_view file;
+            std::string_view function;
+            std::uint32_t line;
+            std::uint32_t column;
+
+            bool operator<(const site_key &other) const noexcept {
+                return std::tie(file, line, column, function) <
+                       std::tie(other.file, other.line, other.column, other.function);
+            }
+        };
+
+        struct site_slot {
+            std::uint64_t allocations = 0;
+            std::uint64_t bytes = 0;
+        };
+
+        struct shard {
+            type_slot types[max_types];
+            // Call sites are recorded only on request, so a lock is affordable there
+            std::mutex sites_mutex;
+            std::map<site_key, site_slot> sites;
+        };
+
+        struct registry {
+            std::mutex mutex;
+            std::vector<std::string> type_names{"(other types)"};
+            std::vector<shard *> shards;
+            // The counts of the threads that have exited, updated under `mutex`
+            shard retired;
+        };
+
+        // Never destroyed, so that blocks freed during static destruction can still be counted
+        inline registry &global() {
+            static registry *instance = new registry;
+            return *instance;
+        }
+
+        template<typename Counter, typename Value>
+        void add(std::atomic<Counter> &counter, Value value) noexcept {
+            counter.store(counter.load(std::memory_order_relaxed) + static_cast<Counter>(value),
+                          std::memory_order_relaxed);
+        }
+
+        inline void fold(shard &into, shard &from) {
+            for (std::uint32_t type = 0; type < max_types; ++type) {
+                type_slot &to = into.types[type];
+                type_slot &slot = from.types[type];
+                add(to.live_blocks, slot.live_blocks.load(std::memory_order_relaxed));
+                add(to.live_bytes, slot.live_bytes.load(std::memory_order_relaxed));
+                add(to.allocations, slot.allocations.load(std::memory_order_relaxed));
+                add(to.copies, slot.copies.load(std::memory_order_relaxed));
+                add(to.moves, slot.moves.load(std::memory_order_relaxed));
+                to.peak_use_count.store(std::max(to.peak_use_count.load(std::memory_order_relaxed),
+                                                 slot.peak_use_count.load(std::memory_order_relaxed)),
+                                        std::memory_order_relaxed);
+            }
+            for (const auto &[key, site]: from.sites) {
+                into.sites[key].allocations += site.allocations;
+                into.sites[key].bytes += site.bytes;
+            }
+        }
+
+        // The shard of the calling thread, registered while the thread lives and folded into the retired counts
+        // when it exits
+        class shard_owner {
+        public:
+            shard_owner() : shard_(new shard) {
+                std::lock_guard<std::mutex> lock(global().mutex);
+                global().shards.push_back(shard_);
+            }
+
+            shard_owner(const shard_owner &) = delete;
+
+            shard_owner &operator=(const shard_owner &) = delete;
+
+            ~shard_owner();
+
+            shard &get() noexcept {
+                return *shard_;
+            }
+
+        private:
+            shard *shard_;
+        };
+
+        // Set when the shard of the thread has been folded: later counts go to the retired shard
+        inline thread_local bool exited = false;
+
+        inline thread_local shard_owner local;
+
+        inline shard_owner::~shard_owner() {
+            {
+                std::lock_guard<std::mutex> lock(global().mutex);
+                auto &shards = global().shards;
+                std::erase(shards, shard_);
+                std::lock_guard<std::mutex> sites_lock(shard_->sites_mutex);
+                fold(global().retired, *shard_);
+            }
+            exited = true;
+            delete shard_;
+        }
+
+        // Run update(shard) on the shard the calling thread counts in
+        template<typename Update>
+        void update(Update update) noexcept {
+            if (exited) {
+                std::lock_guard<std::mutex> lock(global().mutex);
+                update(global().retired);
+            } else {
+                update(local.get());
+            }
+        }
+
+        inline std::uint32_t register_type(std::string_view name) {
+            std::lock_guard<std::mutex> lock(global().mutex);
+            auto &names = global().type_names;
+            if (names.size() == max_types) {
+                return 0;
+            }
+            names.emplace_back(name);
+            return static_cast<std::uint32_t>(names.size() - 1);
+        }
+
+        inline void append_string(std::string &json, std::string_view text) {
+            json += '"';
+            for (char c: text) {
+                if (c == '"' || c == '\\') {
+                    json += '\\';
+                    json += c;
+                } else if (static_cast<unsigned char>(c) < 0x20) {
+                    constexpr char hex[] = "0123456789abcdef";
+                    json += "\\u00";
+                    json += hex[(c >> 4) & 0xf];
+                    json += hex[c & 0xf];
+                } else {
+                    json += c;
+                }
+            }
+            json += '"';
+        }
+
+        template<typename Number>
+        void append_field(std::string &json, std::string_view name, Number value) {
+            json += ", ";
+            append_string(json, name);
+            json += ": ";
+            json += std::to_string(value);
+        }
+    }  // namespace detail
+
+    // The index the counters of T are kept under
+    template<typename T>
+    std::uint32_t type_id() {
+        static const std::uint32_t id = detail::register_type(type_name<T>());
+        return id;
+    }
+
+    // Hooks called by shared_ptr.h
+
+    inline void record_allocation(std::uint32_t type, std::size_t bytes) noexcept {
+        detail::update([&](detail::shard &shard) {
+            detail::type_slot &slot = shard.types[type];
+            detail::add(slot.live_blocks, 1);
+            detail::add(slot.live_bytes, bytes);
+            detail::add(slot.allocations, 1);
+        });
+    }
+
+    inline void record_free(std::uint32_t type, std::size_t bytes) noexcept {
+        detail::update([&](detail::shard &shard) {
+            detail::type_slot &slot = shard.types[type];
+            detail::add(slot.live_blocks, -1);
+            detail::add(slot.live_bytes, -static_cast<std::int64_t>(bytes));
+        });
+    }
+
+    inline void record_copy(std::uint32_t type, std::size_t use_count) noexcept {
+        detail::update([&](detail::shard &shard) {
+            detail::type_slot &slot = shard.types[type];
+            detail::add(slot.copies, 1);
+            if (use_count > slot.peak_use_count.load(std::memory_order_relaxed)) {
+                slot.peak_use_count.store(use_count, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    inline void record_move(std::uint32_t type) noexcept {
+        detail::update([&](detail::shard &shard) {
+            detail::add(shard.types[type].moves, 1);
+        });
+    }
+
+    inline void record_call_site(const std::source_location &location, std::size_t bytes) noexcept {
+        detail::update([&](detail::shard &shard) {
+            std::lock_guard<std::mutex> lock(shard.sites_mutex);
+            detail::site_slot &site = shard.sites[{location.file_name(), location.function_name(), location.line(),
+                                                   location.column()}];
+            ++site.allocations;
+            site.bytes += bytes;
+        });
+    }
+
+    inline const type_counters *snapshot::find(std::string_view type) const noexcept {
+        for (const type_counters &counters: types) {
+            if (counters.type == type) {
+                return &counters;
+            }
+        }
+        return nullptr;
+    }
+
+    inline std::string snapshot::to_json() const {
+        std::string json = "{\"types\": [";
+        for (std::size_t i = 0; i < types.size(); ++i) {
+            const type_counters &counters = types[i];
+            json += i == 0 ? "{\"type\": " : ", {\"type\": ";
+            detail::append_string(json, counters.type);
+            detail::append_field(json, "live_blocks", counters.live_blocks);
+            detail::append_field(json, "live_bytes", counters.live_bytes);
+            detail::append_field(json, "allocations", counters.allocations);
+            detail::append_field(json, "copies", counters.copies);
+            detail::append_field(json, "moves", counters.moves);
+            detail::append_field(json, "peak_use_count", counters.peak_use_count);
+            json += '}';
+        }
+        json += "], \"call_sites\": [";
+        for (std::size_t i = 0; i < call_sites.size(); ++i) {
+            const call_site_counters &site = call_sites[i];
+            json += i == 0 ? "{\"file\": " : ", {\"file\": ";
+            detail::append_string(json, site.file);
+            json += ", \"function\": ";
+            detail::append_string(json, site.function);
+            detail::append_field(json, "line", site.line);
+            detail::append_field(json, "allocations", site.allocations);
+            detail::append_field(json, "bytes", site.bytes);
+            json += '}';
+        }
+        json += "]}";
+        return json;
+    }
+
+    inline snapshot take_snapshot() {
+        using namespace detail;
+        std::lock_guard<std::mutex> lock(global().mutex);
+        shard total;
+        fold(total, global().retired);
+        for (shard *thread: global().shards) {
+            std::lock_guard<std::mutex> sites_lock(thread->sites_mutex);
+            fold(total, *thread);
+        }
+
+        snapshot result;
+        const auto &names = global().type_names;
+        for (std::uint32_t type = 0; type < names.size(); ++type) {
+            const type_slot &slot = total.types[type];
+            type_counters counters{names[type], slot.live_blocks.load(), slot.live_bytes.load(),
+                                   slot.allocations.load(), slot.copies.load(), slot.moves.load(),
+                                   slot.peak_use_count.load()};
+            if (counters.allocations != 0 || counters.copies != 0 || counters.moves != 0 ||
+                counters.live_blocks != 0) {
+                result.types.push_back(std::move(counters));
+            }
+        }
+        for (const auto &[key, site]: total.sites) {
+            result.call_sites.push_back({std::string(key.file), std::string(key.function), key.line,
+                                         site.allocations, site.bytes});
+        }
+        return result;
+    }
+}  // namespace smart_pointer::instrumentation
+
+#endif  // MP_CPP_HW1_INSTRUMENTATION
@@ -0,0 +1,240 @@
+#ifndef MP_CPP_HW1_INTRUSIVE_PTR
+#define MP_CPP_HW1_INTRUSIVE_PTR
+
+#include <concepts>  // std::same_as, std::convertible_to
+#include <cstddef>  // std::size_t, std::nullptr_t
+#include <type_traits>  // std::true_type
+#include <utility>  // std::forward, std::exchange
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // A policy that can count references kept inside the object
+    template<typename P>
+    concept intrusive_count_policy = requires(typename P::ref_count &count) {
+        count.add_ref();
+        { count.release() } -> std::same_as<bool>;
+        { count.use_count() } -> std::convertible_to<std::size_t>;
+    };
+
+    template<typename T>
+    class intrusive_ptr;
+
+    // Base class keeping the reference count inside objects of the class T derived from it (CRTP). The count is
+    // updated according to Policy, like the one of shared_ptr. The object is deleted as a T when the last
+    // intrusive_ptr to it goes away, so a hierarchy of classes needs a virtual destructor in T
+    template<typename T, intrusive_count_policy Policy = atomic_count>
+    class ref_counted {
+    public:
+        // Get the number of intrusive_ptrs to the object
+        [[nodiscard]] std::size_t use_count() const noexcept;
+
+    protected:
+        ref_counted() noexcept = default;
+
+        // A copy is a new object: nobody refers to it yet
+        ref_counted(const ref_counted &) noexcept {}
+
+        // Assignment changes the value of the object, not the references to it
+        ref_counted &operator=(const ref_counted &) noexcept {
+            return *this;
+        }
+
+        ~ref_counted() = default;
+
+    private:
+        template<typename>
+        friend class intrusive_ptr;
+
+        mutable typename Policy::ref_count count_;
+
+        void add_ref() const noexcept;
+
+        void release() const noexcept;
+    };
+
+    // Pointer to an object of a class derived from ref_counted. The handle is a single pointer: creating one from
+    // a raw pointer only increments the count inside the object, so it can be done as many times as needed, even
+    // from `this`
+    template<typename T>
+    class intrusive_ptr {
+    public:
+        using element_type = T;
+
+        // Constructs an empty intrusive_ptr
+        constexpr intrusive_ptr() noexcept = default;
+
+        // Constructs another empty intrusive_ptr
+        constexpr intrusive_ptr(std::nullptr_t) noexcept {}
+
+        // Construct an intrusive_ptr that shares ownership of the given object
+        explicit intrusive_ptr(T *obj) noexcept;
+
+        // Copy constructor
+        intrusive_ptr(const intrusive_ptr &other) noexcept;
+
+        // Move constructor
+        intrusive_ptr(intrusive_ptr &&other) noexcept;
+
+        // Converting copy constructor from a pointer to a derived class
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        intrusive_ptr(const intrusive_ptr<Y> &other) noexcept;
+
+        // Converting move constructor
+        template<typename Y>
+            requires std::convertible_to<Y *, T *>
+        intrusive_ptr(intrusive_ptr<Y> &&other) noexcept;
+
+        // Destructor
+        ~intrusive_ptr();
+
+        // Copy assignment operator
+        intrusive_ptr &operator=(const intrusive_ptr &other) noexcept;
+
+        // Move assignment operator
+        intrusive_ptr &operator=(intrusive_ptr &&other) noexcept;
+
+        // Dereference operator
+        T &operator*() const noexcept {
+            return *obj_;
+        }
+
+        // Member access operator
+        T *operator->() const noexcept {
+            return obj_;
+        }
+
+        // Boolean conversion operator
+        explicit operator bool() const noexcept {
+            return obj_ != nullptr;
+        }
+
+        // Get the number of intrusive_ptrs to the object
+        [[nodiscard]] std::size_t use_count() const noexcept;
+
+        // Release ownership of the object
+        void reset() noexcept;
+
+        // Release ownership of the object and share ownership of the given one
+        void reset(T *obj) noexcept;
+
+        // Get a raw pointer to the object
+        T *get() const noexcept {
+            return obj_;
+        }
+
+    private:
+        template<typename>
+        friend class intrusive_ptr;
+
+        T *obj_ = nullptr;
+    };
+
+    template<typename T, intrusive_count_policy Policy>
+    std::size_t ref_counted<T, Policy>::use_count() const noexcept {
+        return count_.use_count();
+    }
+
+    template<typename T, intrusive_count_policy Policy>
+    void ref_counted<T, Policy>::add_ref() const noexcept {
+        count_.add_ref();
+    }
+
+    template<typename T, intrusive_count_policy Policy>
+    void ref_counted<T, Policy>::release() const noexcept {
+        if (count_.release()) {
+            delete static_cast<const T *>(this);
+        }
+    }
+
+    template<typename T>
+    intrusive_ptr<T>::intrusive_ptr(T *obj) noexcept : obj_(obj) {
+        if (obj_) {
+            obj_->add_ref();
+        }
+    }
+
+    template<typename T>
+    intrusive_ptr<T>::intrusive_ptr(const intrusive_ptr &other) noexcept : intrusive_ptr(other.obj_) {}
+
+    template<typename T>
+    intrusive_ptr<T>::intrusive_ptr(intrusive_ptr &&other) noexcept : obj_(std::exchange(other.obj_, nullptr)) {}
+
+    template<typename T>
+    template<typename Y>
+        requires std::convertible_to<Y *, T *>
+    intrusive_ptr<T>::intrusive_ptr(const intrusive_ptr<Y> &other) noexcept : intrusive_ptr(other.obj_) {}
+
+    template<typename T>
+    template<typename Y>
+        requires std::convertible_to<Y *, T *>
+    intrusive_ptr<T>::intrusive_ptr(intrusive_ptr<Y> &&other) noexcept : obj_(std::exchange(other.obj_, nullptr)) {}
+
+    template<typename T>
+    intrusive_ptr<T>::~intrusive_ptr() {
+        if (obj_) {
+            obj_->release();
+        }
+    }
+
+    template<typename T>
+    intrusive_ptr<T> &intrusive_ptr<T>::operator=(const intrusive_ptr &other) noexcept {
+        // Take the new reference first: `other` may be owned by the object we are about to release
+        if (other.obj_) {
+            other.obj_->add_ref();
+        }
+        if (T *old = std::exchange(obj_, other.obj_)) {
+            old->release();
+        }
+        return *this;
+    }
+
+    template<typename T>
+    intrusive_ptr<T> &intrusive_ptr<T>::operator=(intrusive_ptr &&other) noexcept {
+        if (this != &other) {
+            if (T *old = std::exchange(obj_, std::exchange(other.obj_, nullptr))) {
+                old->release();
+            }
+        }
+        return *this;
+    }
+
+    template<typename T>
+    std::size_t intrusive_ptr<T>::use_count() const noexcept {
+        return obj_ ? obj_->use_count() : 0;
+    }
+
+    template<typename T>
+    void intrusive_ptr<T>::reset() noexcept {
+        if (T *old = std::exchange(obj_, nullptr)) {
+            old->release();
+        }
+    }
+
+    template<typename T>
+    void intrusive_ptr<T>::reset(T *obj) noexcept {
+        *this = intrusive_ptr(obj);
+    }
+
+    // Create an object of a class derived from ref_counted and the first pointer to it
+    template<typename T, typename... Args>
+    intrusive_ptr<T> make_intrusive(Args &&... args) {
+        return intrusive_ptr<T>(new T(std::forward<Args>(args)...));
+    }
+
+    template<typename T>
+    struct is_trivially_relocatable<intrusive_ptr<T>> : std::true_type {};
+
+    template<typename T, typename Y>
+    intrusive_ptr<T> static_pointer_cast(const intrusive_ptr<Y> &ptr) noexcept {
+        return intrusive_ptr<T>(static_cast<T *>(ptr.get()));
+    }
+
+    template<typename T, typename Y>
+    intrusive_ptr<T> dynamic_pointer_cast(const intrusive_ptr<Y> &ptr) noexcept {
+        return intrusive_ptr<T>(dynamic_cast<T *>(ptr.get()));
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_INTRUSIVE_PTR
@@ -0,0 +1,144 @@
+#ifndef MP_CPP_HW1_MAPPED_ARRAY
+#define MP_CPP_HW1_MAPPED_ARRAY
+
+#include <cerrno>  // errno
+#include <cstddef>  // std::size_t
+#include <filesystem>  // std::filesystem::path
+#include <stdexcept>  // std::invalid_argument, std::out_of_range
+#include <system_error>  // std::system_error, std::generic_category
+#include <type_traits>  // std::is_unbounded_array_v, std::is_trivially_copyable_v, std::is_const_v,
+                       // std::remove_all_extents_t
+
+#include <fcntl.h>  // open
+#include <sys/mman.h>  // mmap, munmap, madvise
+#include <sys/stat.h>  // fstat
+#include <unistd.h>  // close, sysconf
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // How the pages of a mapped file are going to be read
+    enum class map_advice {
+        // Front to back: the kernel reads ahead aggressively and the whole range is prefetched
+        sequential,
+        // In no particular order: no read-ahead
+        random,
+        // Left to the kernel
+        normal
+    };
+
+    // An array mapped from a file and the number of its elements
+    template<typename T, count_policy Policy = atomic_count>
+    struct mapped_array {
+        shared_ptr<T, Policy> data;
+        std::size_t size = 0;
+    };
+
+    // Map everything from the offset to the end of the file
+    inline constexpr std::size_t whole_file = static_cast<std::size_t>(-1);
+
+    namespace detail {
+        // Unmaps a file mapping when the last owner of the array goes
+        struct unmap_deleter {
+            void *base;
+            std::size_t length;
+            // Innermost elements mapped, for shared_ptr::size()
+            std::size_t elements;
+
+            [[nodiscard]] std::size_t extent() const noexcept {
+                return elements;
+            }
+
+            void operator()(const void *) const noexcept {
+                ::munmap(base, length);
+            }
+        };
+
+        // Closes the file once it is mapped or the mapping has failed
+        class file_descriptor {
+        public:
+            explicit file_descriptor(int fd) noexcept : fd_(fd) {}
+
+            file_descriptor(const file_descriptor &) = delete;
+
+            file_descriptor &operator=(const file_descriptor &) = delete;
+
+            ~file_descriptor() {
+                ::close(fd_);
+            }
+
+            [[nodiscard]] int get() const noexcept {
+                return fd_;
+            }
+
+        private:
+            int fd_;
+        };
+    }  // namespace detail
+
+    // Map `count` elements of type E starting `offset` bytes into the file, without copying them: the array is
+    // backed by the page cache and is unmapped when the last owner goes. An array of const elements is a read-only
+    // view of the file; an array of mutable elements is a private copy-on-write view, so writes to it never reach
+    // the file. The elements are the bytes of the file, hence E must be trivially copyable.
+    // Throws std::system_error if the file cannot be opened or mapped and std::out_of_range if it is too short
+    template<typename T, count_policy Policy = atomic_count>
+        requires std::is_unbounded_array_v<T> && std::is_trivially_copyable_v<std::remove_extent_t<T>>
+    mapped_array<T, Policy> map_shared(const std::filesystem::path &path, std::size_t offset = 0,
+                                       std::size_t count = whole_file, map_advice advice = map_advice::sequential) {
+        using element_type = std::remove_extent_t<T>;
+        constexpr bool writable = !std::is_const_v<std::remove_all_extents_t<T>>;
+
+        if (offset % alignof(element_type) != 0) {
+            throw std::invalid_argument("map_shared: offset is not aligned for the element type");
+        }
+        detail::file_descriptor file(::open(path.c_str(), O_RDONLY | O_CLOEXEC));
+        if (file.get() < 0) {
+            throw std::system_error(errno, std::generic_category(), "map_shared: cannot open " + path.string());
+        }
+        struct stat status{};
+        if (::fstat(file.get(), &status) != 0) {
+            throw std::system_error(errno, std::generic_category(), "map_shared: cannot stat " + path.string());
+        }
+        auto file_size = static_cast<std::size_t>(status.st_size);
+        if (offset > file_size) {
+            throw std::out_of_range("map_shared: offset is past the end of the file");
+        }
+        if (count == whole_file) {
+            count = (file_size - offset) / sizeof(element_type);
+        } else if (count > (file_size - offset) / sizeof(element_type)) {
+            throw std::out_of_range("map_shared: the file is shorter than the requested array");
+        }
+        if (count == 0) {
+            return {};
+        }
+
+        // mmap wants the offset at a page boundary, so the mapping starts at the page holding the first element
+        static const auto page = static_cast<std::size_t>(::sysconf(_SC_PAGESIZE));
+        std::size_t skipped = offset % page;
+        std::size_t length = skipped + count * sizeof(element_type);
+        void *base = ::mmap(nullptr, length, writable ? PROT_READ | PROT_WRITE : PROT_READ,
+                            writable ? MAP_PRIVATE : MAP_SHARED, file.get(), static_cast<off_t>(offset - skipped));
+        if (base == MAP_FAILED) {
+            throw std::system_error(errno, std::generic_category(), "map_shared: cannot map " + path.string());
+        }
+        // Only hints: the mapping works the same if the kernel ignores them
+        switch (advice) {
+            case map_advice::sequential:
+                ::madvise(base, length, MADV_SEQUENTIAL);
+                ::madvise(base, length, MADV_WILLNEED);
+                break;
+            case map_advice::random:
+                ::madvise(base, length, MADV_RANDOM);
+                break;
+            case map_advice::normal:
+                break;
+        }
+
+        auto *data = reinterpret_cast<element_type *>(static_cast<char *>(base) + skipped);
+        // The control block is the only allocation; if it fails, the deleter unmaps the file
+        constexpr std::size_t row = sizeof(element_type) / sizeof(std::remove_all_extents_t<T>);
+        return {shared_ptr<T, Policy>(data, detail::unmap_deleter{base, length, count * row}), count};
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_MAPPED_ARRAY
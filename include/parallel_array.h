@@ -0,0 +1,186 @@
+#ifndef MP_CPP_HW1_PARALLEL_ARRAY
+#define MP_CPP_HW1_PARALLEL_ARRAY
+
+#include <algorithm>  // std::for_each, std::clamp, std::min
+#include <cstddef>  // std::size_t
+#include <exception>  // std::exception_ptr, std::current_exception, std::rethrow_exception
+#include <execution>  // std::execution::par, std::is_execution_policy_v
+#include <numeric>  // std::iota
+#include <thread>  // std::thread::hardware_concurrency
+#include <type_traits>  // std::is_same_v, std::remove_cvref_t
+#include <vector>  // std::vector
+
+#include "shared_ptr.h"
+
+// make_shared and allocate_shared for arrays taking an execution policy. They live apart from shared_ptr.h because
+// the parallel algorithms of libstdc++ need TBB: only the programs that include this header have to link it
+
+namespace smart_pointer {
+    namespace detail::parallel {
+        // Arrays with fewer innermost elements than this per chunk are built and destroyed on the calling thread
+        constexpr std::size_t min_chunk = std::size_t(1) << 16;
+
+        // The policy lets the elements be handled on other threads. Unsequenced policies would also allow one thread
+        // to interleave several constructors, which constructors that allocate or throw cannot bear, so only the
+        // threads are taken from them
+        template<typename ExecutionPolicy>
+        constexpr bool uses_threads =
+                std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, std::execution::parallel_policy> ||
+                std::is_same_v<std::remove_cvref_t<ExecutionPolicy>, std::execution::parallel_unsequenced_policy>;
+
+        // Number of chunks to split `count` units of `row` innermost elements each into
+        inline std::size_t chunks_for(std::size_t count, std::size_t row) noexcept {
+            std::size_t threads = std::max(1u, std::thread::hardware_concurrency());
+            return std::min(count, std::clamp(count * row / min_chunk, std::size_t(1), threads * 4));
+        }
+
+        // First unit of a chunk: the units are shared out as evenly as possible
+        inline std::size_t chunk_begin(std::size_t count, std::size_t chunks, std::size_t chunk) noexcept {
+            return chunk * (count / chunks) + std::min(chunk, count % chunks);
+        }
+
+        // Call body(chunk, begin, end) once for each of `chunks` consecutive parts of [0, count), on the threads of
+        // the parallel algorithms. The body must not throw. Either throws before calling the body at all, or calls it
+        // for every chunk: if the algorithm fails to start some of them, they run on the calling thread
+        template<typename Body>
+        void for_chunks(std::size_t count, std::size_t chunks, Body body) {
+            std::vector<std::size_t> indices(chunks);
+            std::iota(indices.begin(), indices.end(), std::size_t(0));
+            std::vector<unsigned char> done(chunks, 0);
+            auto run = [&](std::size_t chunk) noexcept {
+                body(chunk, chunk_begin(count, chunks, chunk), chunk_begin(count, chunks, chunk + 1));
+                done[chunk] = 1;
+            };
+            try {
+                std::for_each(std::execution::par, indices.begin(), indices.end(), run);
+            } catch (...) {
+                for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                    if (!done[chunk]) {
+                        run(chunk);
+                    }
+                }
+            }
+        }
+
+        // Destroys the elements of a block on several threads when there are enough of them
+        struct parallel_destroy {
+            template<typename Alloc, typename E>
+            void operator()(Alloc &alloc, E *first, std::size_t count) const noexcept {
+                std::size_t chunks = chunks_for(count, 1);
+                if (chunks > 1) {
+                    try {
+                        for_chunks(count, chunks, [&](std::size_t, std::size_t begin, std::size_t end) noexcept {
+                            Alloc chunk_alloc(alloc);
+                            destroy_elements(chunk_alloc, first + begin, end - begin);
+                        });
+                        return;
+                    } catch (...) {
+                        // Nothing has been destroyed yet: do it all here
+                    }
+                }
+                destroy_elements(alloc, first, count);
+            }
+        };
+
+        // make_array_block, with the rows of elements constructed on several threads. If any constructor throws,
+        // the elements built by the other threads are destroyed and the first exception is rethrown
+        template<typename T, typename Policy, typename Alloc>
+        auto make_array_block(const Alloc &alloc, std::size_t count, const T *u = nullptr) {
+            using elementary_type = std::remove_cv_t<std::remove_all_extents_t<T>>;
+            constexpr std::size_t row = sizeof(T) / sizeof(elementary_type);
+            auto block = allocate_array_block<T, Policy, parallel_destroy>(alloc, count);
+            using element_allocator = typename std::remove_pointer_t<decltype(block)>::element_allocator;
+            auto pattern = reinterpret_cast<const elementary_type *>(u);
+            std::size_t chunks = chunks_for(count, row);
+            try {
+                if (chunks <= 1) {
+                    element_allocator element_alloc(alloc);
+                    construct_elements(element_alloc, block->data(), count, row, pattern);
+                    return block;
+                }
+                std::vector<std::exception_ptr> errors(chunks);
+                for_chunks(count, chunks, [&](std::size_t chunk, std::size_t begin, std::size_t end) noexcept {
+                    try {
+                        element_allocator element_alloc(alloc);
+                        construct_elements(element_alloc, block->data() + begin * row, end - begin, row, pattern);
+                    } catch (...) {
+                        errors[chunk] = std::current_exception();
+                    }
+                });
+                std::exception_ptr error;
+                for (std::size_t chunk = 0; chunk < chunks; ++chunk) {
+                    if (errors[chunk] && !error) {
+                        error = errors[chunk];
+                    }
+                }
+                if (error) {
+                    // A failed chunk has already destroyed what it built
+                    element_allocator element_alloc(alloc);
+                    for (std::size_t chunk = chunks; chunk-- > 0;) {
+                        if (!errors[chunk]) {
+                            std::size_t begin = chunk_begin(count, chunks, chunk);
+                            std::size_t end = chunk_begin(count, chunks, chunk + 1);
+                            destroy_elements(element_alloc, block->data() + begin * row, (end - begin) * row);
+                        }
+                    }
+                    std::rethrow_exception(error);
+                }
+            } catch (...) {
+                block->deallocate();
+                throw;
+            }
+            return block;
+        }
+    }  // namespace detail::parallel
+
+    // allocate_shared with an execution policy
+    // With std::execution::par or par_unseq the elements of a big array are constructed on several threads, and
+    // destroyed on several threads when the last owner goes, in no particular order. Other policies, and arrays
+    // too small to be worth it, are handled on the calling thread like allocate_shared does
+
+    template<typename T, count_policy Policy = atomic_count, typename ExecutionPolicy, typename Alloc>
+        requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>> &&
+                 std::is_array_v<T> && (!is_type_complete_v<T>)
+    shared_ptr<T, Policy> allocate_shared(ExecutionPolicy &&, const Alloc &alloc, std::size_t N) {
+        if constexpr (detail::parallel::uses_threads<ExecutionPolicy>) {
+            auto block = detail::parallel::make_array_block<std::remove_extent_t<T>, Policy>(alloc, N);
+            return detail::shared_ptr_access::make<T, Policy>(
+                    reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
+        } else {
+            return allocate_shared<T, Policy>(alloc, N);
+        }
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename ExecutionPolicy, typename Alloc>
+        requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>> &&
+                 std::is_array_v<T> && (!is_type_complete_v<T>)
+    shared_ptr<T, Policy> allocate_shared(ExecutionPolicy &&, const Alloc &alloc, std::size_t N,
+                                         const std::remove_extent_t<T> &u) {
+        if constexpr (detail::parallel::uses_threads<ExecutionPolicy>) {
+            auto block = detail::parallel::make_array_block<std::remove_extent_t<T>, Policy>(alloc, N, &u);
+            return detail::shared_ptr_access::make<T, Policy>(
+                    reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
+        } else {
+            return allocate_shared<T, Policy>(alloc, N, u);
+        }
+    }
+
+    // make_shared with an execution policy, e.g. make_shared<T[]>(std::execution::par, N, u)
+
+    template<typename T, count_policy Policy = atomic_count, typename ExecutionPolicy>
+        requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>> &&
+                 std::is_array_v<T> && (!is_type_complete_v<T>)
+    shared_ptr<T, Policy> make_shared(ExecutionPolicy &&policy, std::size_t N) {
+        return allocate_shared<T, Policy>(std::forward<ExecutionPolicy>(policy), detail::default_allocator<T>(), N);
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename ExecutionPolicy>
+        requires std::is_execution_policy_v<std::remove_cvref_t<ExecutionPolicy>> &&
+                 std::is_array_v<T> && (!is_type_complete_v<T>)
+    shared_ptr<T, Policy> make_shared(ExecutionPolicy &&policy, std::size_t N, const std::remove_extent_t<T> &u) {
+        return allocate_shared<T, Policy>(std::forward<ExecutionPolicy>(policy), detail::default_allocator<T>(), N,
+                                          u);
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_PARALLEL_ARRAY
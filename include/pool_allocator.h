@@ -0,0 +1,224 @@
+#ifndef MP_CPP_HW1_POOL_ALLOCATOR
+#define MP_CPP_HW1_POOL_ALLOCATOR
+
+#include <atomic>  // std::atomic
+#include <cstddef>  // std::size_t
+#include <cstdint>  // std::uintptr_t
+#include <memory>  // std::allocator
+#include <mutex>  // std::mutex, std::lock_guard
+#include <new>  // std::align_val_t
+#include <vector>  // std::vector
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    namespace detail::pool {
+        // Chunks are handed out in size classes of 16 bytes up to 256 bytes, which covers control blocks and
+        // make_shared blocks of small objects. Bigger requests go to the global operator new
+        constexpr std::size_t granularity = 16;
+        constexpr std::size_t max_chunk_size = 256;
+        constexpr std::size_t size_classes = max_chunk_size / granularity;
+
+        // Chunks are carved from slabs aligned to their size, so the slab of any chunk is found by masking its address
+        constexpr std::size_t slab_size = 64 * 1024;
+
+        class heap;
+
+        struct alignas(64) slab_header {
+            heap *owner;
+            std::size_t size_class;
+        };
+
+        struct free_chunk {
+            free_chunk *next;
+        };
+
+        // The free lists of one thread. Only the owning thread allocates from a heap and pushes to its local lists;
+        // other threads return chunks through the lock-free remote lists, which the owner takes over in one exchange
+        // once its local list runs dry. A heap is never destroyed: when its thread exits it is handed to the next
+        // new thread together with the chunks still in use
+        class heap {
+        public:
+            void *allocate(std::size_t size_class) {
+                free_chunk *chunk = local_[size_class];
+                if (!chunk) {
+                    chunk = remote_[size_class].exchange(nullptr, std::memory_order_acquire);
+                    if (!chunk) {
+                        return carve(size_class);
+                    }
+                }
+                local_[size_class] = chunk->next;
+                return chunk;
+            }
+
+            // Return a chunk from the owning thread
+            void deallocate_local(void *ptr, std::size_t size_class) noexcept {
+                auto chunk = static_cast<free_chunk *>(ptr);
+                chunk->next = local_[size_class];
+                local_[size_class] = chunk;
+            }
+
+            // Return a chunk from any other thread
+            void deallocate_remote(void *ptr, std::size_t size_class) noexcept {
+                auto chunk = static_cast<free_chunk *>(ptr);
+                chunk->next = remote_[size_class].load(std::memory_order_relaxed);
+                while (!remote_[size_class].compare_exchange_weak(chunk->next, chunk, std::memory_order_release,
+                                                                  std::memory_order_relaxed)) {}
+            }
+
+            // Take an abandoned heap or create a new one for the calling thread
+            static heap *acquire() {
+                auto &registry = abandoned();
+                {
+                    std::lock_guard<std::mutex> lock(registry.mutex);
+                    if (!registry.heaps.empty()) {
+                        heap *adopted = registry.heaps.back();
+                        registry.heaps.pop_back();
+                        return adopted;
+                    }
+                }
+                return new heap();
+            }
+
+            // Give the heap of an exiting thread away
+            static void abandon(heap *orphan) {
+                auto &registry = abandoned();
+                std::lock_guard<std::mutex> lock(registry.mutex);
+                registry.heaps.push_back(orphan);
+            }
+
+        private:
+            free_chunk *local_[size_classes] = {};
+            std::atomic<free_chunk *> remote_[size_classes] = {};
+            unsigned char *next_[size_classes] = {};
+            unsigned char *end_[size_classes] = {};
+
+            struct registry {
+                std::mutex mutex;
+                std::vector<heap *> heaps;
+            };
+
+            // Never destroyed, so that threads exiting during static destruction can still use it
+            static registry &abandoned() {
+                static auto instance = new registry();
+                return *instance;
+            }
+
+            void *carve(std::size_t size_class) {
+                std::size_t chunk_size = (size_class + 1) * granularity;
+                if (next_[size_class] + chunk_size > end_[size_class]) {
+                    void *memory = ::operator new(slab_size, std::align_val_t(slab_size));
+                    auto slab = ::new (memory) slab_header{this, size_class};
+                    next_[size_class] = reinterpret_cast<unsigned char *>(slab) + sizeof(slab_header);
+                    end_[size_class] = reinterpret_cast<unsigned char *>(slab) + slab_size;
+                }
+                void *chunk = next_[size_class];
+                next_[size_class] += chunk_size;
+                return chunk;
+            }
+        };
+
+        // Set when the heap of the thread has been handed over: later allocations go to the shared heap
+        inline thread_local bool exited = false;
+
+        // The heap of the calling thread, handed over to the next thread when this one exits
+        struct thread_heap {
+            heap *instance = nullptr;
+
+            // Later thread_local destructors check `exited` rather than `instance`: the object is dead after this,
+            // so the compiler may drop a store to it made here
+            ~thread_heap() {
+                if (instance) {
+                    heap::abandon(instance);
+                }
+                exited = true;
+            }
+        };
+
+        inline thread_local thread_heap current;
+
+        // The heap of the thread_local destructors that allocate after the heap of their thread is handed over.
+        // Shared by all exiting threads, under a lock
+        struct shared_heap {
+            std::mutex mutex;
+            heap instance;
+        };
+
+        // Never destroyed, like the registry of abandoned heaps
+        inline shared_heap &exiting() {
+            static auto instance = new shared_heap();
+            return *instance;
+        }
+
+        inline void *allocate(std::size_t bytes) {
+            std::size_t size_class = (bytes - 1) / granularity;
+            if (exited) {
+                auto &shared = exiting();
+                std::lock_guard<std::mutex> lock(shared.mutex);
+                return shared.instance.allocate(size_class);
+            }
+            if (!current.instance) {
+                current.instance = heap::acquire();
+            }
+            return current.instance->allocate(size_class);
+        }
+
+        inline void deallocate(void *ptr) noexcept {
+            auto slab = reinterpret_cast<slab_header *>(reinterpret_cast<std::uintptr_t>(ptr) & ~(slab_size - 1));
+            // Chunks freed by thread_local destructors after the heap was handed over go through the remote lists
+            if (!exited && slab->owner == current.instance) {
+                slab->owner->deallocate_local(ptr, slab->size_class);
+            } else {
+                slab->owner->deallocate_remote(ptr, slab->size_class);
+            }
+        }
+    }  // namespace detail::pool
+
+    // Allocator serving small requests from per-thread pools, so that allocating a control block or a small
+    // make_shared block is a free list pop. Memory may be freed from any thread.
+    // Pools only grow: freed chunks are reused but never returned to the system
+    template<typename T>
+    class pool_allocator {
+    public:
+        using value_type = T;
+
+        pool_allocator() noexcept = default;
+
+        template<typename U>
+        pool_allocator(const pool_allocator<U> &) noexcept {}
+
+        T *allocate(std::size_t n) {
+            if (pooled(n)) {
+                return static_cast<T *>(detail::pool::allocate(n * sizeof(T)));
+            }
+            return std::allocator<T>().allocate(n);
+        }
+
+        void deallocate(T *ptr, std::size_t n) noexcept {
+            if (pooled(n)) {
+                detail::pool::deallocate(ptr);
+            } else {
+                std::allocator<T>().deallocate(ptr, n);
+            }
+        }
+
+        template<typename U>
+        bool operator==(const pool_allocator<U> &) const noexcept {
+            return true;
+        }
+
+    private:
+        static bool pooled(std::size_t n) noexcept {
+            return alignof(T) <= detail::pool::granularity && n > 0 && n <= detail::pool::max_chunk_size / sizeof(T);
+        }
+    };
+
+    // make_shared taking its block from the pool of the calling thread
+    template<typename T, count_policy Policy = atomic_count, typename... Args>
+    auto make_pooled_shared(Args &&... args) {
+        return allocate_shared<T, Policy>(pool_allocator<std::remove_cv_t<std::remove_all_extents_t<T>>>(),
+                                          std::forward<Args>(args)...);
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_POOL_ALLOCATOR
@@ -1,7 +1,24 @@
 #ifndef MP_CPP_HW1_SHARED_PTR
 #define MP_CPP_HW1_SHARED_PTR
 
+#include <algorithm>  // std::min, std::max
+#include <atomic>  // std::atomic
+#include <concepts>  // std::same_as, std::convertible_to
 #include <cstddef>  // std::size_t
+#include <cstdint>  // std::uint64_t, std::uintptr_t
+#include <cstring>  // std::memcpy
+#include <memory>  // std::allocator_traits, std::default_delete, std::bad_weak_ptr, std::uninitialized_fill_n
+#include <new>  // placement new, std::bad_array_new_length, std::launder
+#include <source_location>  // std::source_location
+#include <span>  // std::span, std::dynamic_extent
+#include <stdexcept>  // std::out_of_range, std::length_error
+#include <type_traits>  // std::is_array_v, std::is_invocable_v, std::remove_extent_t
+#include <utility>  // std::forward, std::move, std::as_const, std::exchange
+#include <vector>  // std::vector
+
+#ifdef MP_CPP_HW1_INSTRUMENT
+#include "instrumentation.h"
+#endif
 
 namespace smart_pointer {
     template<typename, typename = void>
@@ -11,10 +28,806 @@ namespace smart_pointer {
     constexpr bool is_type_complete_v
             <T, std::void_t<decltype(sizeof(T))>> = true;
 
-    template<typename T>
+    // Reference counting policies: how the owners and observers of an object update their shared counters.
+    // A policy provides a `counts` type holding the use count and the weak count of a control block;
+    // both start at one, the owners together hold a single weak reference. A policy may also provide a `ref_count`
+    // type, a single use count starting at zero for objects that count their own references (intrusive_ptr.h).
+    // A policy may defer the destruction of objects (deferred_count.h): its static `retire(block)` then takes over
+    // the control blocks whose `counts.release()` returned true, and its `link` type is kept in every block for its
+    // use. A policy collecting cycles (cyclic_count.h) walks the object graph through the control blocks' trace(),
+    // which passes every shared_ptr the managed object holds to the visitor, or returns false if the object does not
+    // list them. The collector calls it on the candidate roots and what they reach when collect_cycles() runs
+
+    // Thread-safe counting, the default. Both counts share one atomic word (the use count in the lower half),
+    // so the last owner can tell that nobody else refers to the block with a single load, like libstdc++ does.
+    // Taking a reference needs no ordering; dropping one is acq_rel so that every use of the object by other
+    // owners happens before its destruction
+    struct atomic_count {
+        class counts {
+        public:
+            // The most owners the use count can hold
+            static constexpr std::size_t max_use_count = 0xffffffff;
+
+            void add_ref() noexcept {
+                value_.fetch_add(use_one, std::memory_order_relaxed);
+            }
+
+            // Register `count` more owners at once, no more than max_use_count in all
+            void add_refs(std::size_t count) noexcept {
+                value_.fetch_add(count * use_one, std::memory_order_relaxed);
+            }
+
+            // Increments the use count unless it already dropped to zero. Returns true on success
+            bool try_add_ref() noexcept {
+                std::uint64_t current = value_.load(std::memory_order_relaxed);
+                while (current & use_mask) {
+                    if (value_.compare_exchange_weak(current, current + use_one, std::memory_order_acq_rel,
+                                                     std::memory_order_relaxed)) {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            // Returns true if the only reference to the block is the calling owner
+            [[nodiscard]] bool unique() const noexcept {
+                return value_.load(std::memory_order_acquire) == (use_one | weak_one);
+            }
+
+            // Returns true if the last owner was dropped
+            bool release() noexcept {
+                return (value_.fetch_sub(use_one, std::memory_order_acq_rel) & use_mask) == use_one;
+            }
+
+            void add_weak_ref() noexcept {
+                value_.fetch_add(weak_one, std::memory_order_relaxed);
+            }
+
+            // Returns true if the last weak reference was dropped
+            bool release_weak() noexcept {
+                // With no owners left weak references are only copied from other weak_ptrs: if ours is the only
+                // one, nobody else can reach the counters and no read-modify-write is needed
+                if (value_.load(std::memory_order_acquire) == weak_one) {
+                    return true;
+                }
+                return (value_.fetch_sub(weak_one, std::memory_order_acq_rel) >> 32) == 1;
+            }
+
+            [[nodiscard]] std::size_t use_count() const noexcept {
+                return value_.load(std::memory_order_relaxed) & use_mask;
+            }
+
+        private:
+            static constexpr std::uint64_t use_one = 1;
+            static constexpr std::uint64_t weak_one = std::uint64_t(1) << 32;
+            static constexpr std::uint64_t use_mask = weak_one - 1;
+            static_assert(use_mask == max_use_count);
+
+            std::atomic<std::uint64_t> value_{use_one | weak_one};
+        };
+
+        // A lone use count for objects that count their own references (see ref_counted), starting at zero
+        class ref_count {
+        public:
+            void add_ref() noexcept {
+                value_.fetch_add(1, std::memory_order_relaxed);
+            }
+
+            // Returns true if the last reference was dropped
+            bool release() noexcept {
+                // The only reference cannot be copied concurrently, so its owner can skip the read-modify-write
+                if (value_.load(std::memory_order_acquire) == 1) {
+                    return true;
+                }
+                return value_.fetch_sub(1, std::memory_order_acq_rel) == 1;
+            }
+
+            [[nodiscard]] std::size_t use_count() const noexcept {
+                return value_.load(std::memory_order_relaxed);
+            }
+
+        private:
+            std::atomic<std::size_t> value_ = 0;
+        };
+    };
+
+    // Plain counting for pointers that never leave one thread
+    struct local_count {
+        class counts {
+        public:
+            void add_ref() noexcept {
+                ++use_count_;
+            }
+
+            void add_refs(std::size_t count) noexcept {
+                use_count_ += count;
+            }
+
+            bool try_add_ref() noexcept {
+                if (use_count_ == 0) {
+                    return false;
+                }
+                ++use_count_;
+                return true;
+            }
+
+            [[nodiscard]] bool unique() const noexcept {
+                return use_count_ == 1 && weak_count_ == 1;
+            }
+
+            bool release() noexcept {
+                return --use_count_ == 0;
+            }
+
+            void add_weak_ref() noexcept {
+                ++weak_count_;
+            }
+
+            bool release_weak() noexcept {
+                return --weak_count_ == 0;
+            }
+
+            [[nodiscard]] std::size_t use_count() const noexcept {
+                return use_count_;
+            }
+
+        private:
+            std::size_t use_count_ = 1;
+            std::size_t weak_count_ = 1;
+        };
+
+        class ref_count {
+        public:
+            void add_ref() noexcept {
+                ++value_;
+            }
+
+            bool release() noexcept {
+                return --value_ == 0;
+            }
+
+            [[nodiscard]] std::size_t use_count() const noexcept {
+                return value_;
+            }
+
+        private:
+            std::size_t value_ = 0;
+        };
+    };
+
+    template<typename P>
+    concept count_policy = requires(typename P::counts &counts) {
+        counts.add_ref();
+        { counts.try_add_ref() } -> std::same_as<bool>;
+        { counts.unique() } -> std::same_as<bool>;
+        { counts.release() } -> std::same_as<bool>;
+        counts.add_weak_ref();
+        { counts.release_weak() } -> std::same_as<bool>;
+        { counts.use_count() } -> std::convertible_to<std::size_t>;
+    };
+
+    template<count_policy Policy>
+    class tracer;
+
+    namespace detail {
+        // What a control block keeps for a policy that does not need anything
+        struct no_link {};
+
+        template<typename P>
+        struct link_of {
+            using type = no_link;
+        };
+
+        template<typename P>
+            requires requires { typename P::link; }
+        struct link_of<P> {
+            using type = typename P::link;
+        };
+
+        // The reference counts shared by all the owners and observers of an object together with a type-erased way
+        // to destroy it. The object is destroyed when the last owner goes, the block itself when the last weak_ptr
+        // goes: all the owners together hold a single weak reference
+        template<count_policy Policy>
+        class control_block_base {
+        public:
+            control_block_base() noexcept = default;
+
+            control_block_base(const control_block_base &) = delete;
+
+            control_block_base &operator=(const control_block_base &) = delete;
+
+            // Register one more owner
+            void add_ref() noexcept {
+                counts_.add_ref();
+#ifdef MP_CPP_HW1_INSTRUMENT
+                instrumentation::record_copy(type_, counts_.use_count());
+#endif
+            }
+
+            // Register `count` more owners, in one update if the policy can do that (counts.add_refs)
+            void add_refs(std::size_t count) noexcept {
+                if constexpr (requires { counts_.add_refs(count); }) {
+                    counts_.add_refs(count);
+#ifdef MP_CPP_HW1_INSTRUMENT
+                    for (std::size_t i = 0; i < count; ++i) {
+                        instrumentation::record_copy(type_, counts_.use_count());
+                    }
+#endif
+                } else {
+                    for (std::size_t i = 0; i < count; ++i) {
+                        add_ref();
+                    }
+                }
+            }
+
+            // Register one more owner unless the object is already destroyed. Returns true on success
+            bool try_add_ref() noexcept {
+                return counts_.try_add_ref();
+            }
+
+            // Unregister an owner, destroying the object when it was the last one
+            void release() noexcept {
+                if constexpr (requires { Policy::retire(this); }) {
+                    // The policy destroys the object later through reclaim()
+                    if (counts_.release()) {
+                        Policy::retire(this);
+                    }
+                } else if (counts_.unique()) {
+                    // The sole owner and no weak_ptr: nobody else can reach the block, so skip the counter updates
+                    dispose();
+                    destroy();
+                } else if (counts_.release()) {
+                    dispose();
+                    release_weak();
+                }
+            }
+
+            // Finish the release of the last owner of a block handed to Policy::retire
+            void reclaim() noexcept {
+                dispose();
+                release_weak();
+            }
+
+            // Register one more weak_ptr
+            void add_weak_ref() noexcept {
+                counts_.add_weak_ref();
+            }
+
+            // Unregister a weak_ptr, freeing the block when nothing refers to it anymore
+            void release_weak() noexcept {
+                if (counts_.release_weak()) {
+                    destroy();
+                }
+            }
+
+            [[nodiscard]] std::size_t use_count() const noexcept {
+                return counts_.use_count();
+            }
+
+            // Number of innermost elements from `element` to the end of the array stored in the block, or 0 if
+            // `element` does not point into such an array. Only the blocks of make_shared know the extent
+            [[nodiscard]] virtual std::size_t elements_from(const void *element) const noexcept {
+                (void) element;
+                return 0;
+            }
+
+            // Bytes of memory the block and the object hold, as far as the block knows
+            [[nodiscard]] virtual std::size_t footprint() const noexcept = 0;
+
+            // Pass every shared_ptr the object holds to `visit`, for a policy that collects cycles (cyclic_count.h).
+            // Returns false if the object does not list them: it has no trace() member
+            virtual bool trace(tracer<Policy> &visit) noexcept {
+                (void) visit;
+                return false;
+            }
+
+            // Storage a deferring policy keeps in the block, e.g. to queue it
+            typename link_of<Policy>::type &link() noexcept {
+                return link_;
+            }
+
+            // The counters themselves, for a deferring policy that has to finish their update
+            typename Policy::counts &counts() noexcept {
+                return counts_;
+            }
+
+            // An owner was moved from one shared_ptr to another, for the instrumentation
+            void moved() noexcept {
+#ifdef MP_CPP_HW1_INSTRUMENT
+                instrumentation::record_move(type_);
+#endif
+            }
+
+        protected:
+#ifdef MP_CPP_HW1_INSTRUMENT
+            virtual ~control_block_base() {
+                instrumentation::record_free(type_, bytes_);
+            }
+#else
+            virtual ~control_block_base() = default;
+#endif
+
+            // Called by the constructor of every block with the type of the object it manages, for the
+            // instrumentation. Must come last: it takes the footprint of the complete block
+            template<typename Object>
+            void created() noexcept {
+#ifdef MP_CPP_HW1_INSTRUMENT
+                type_ = instrumentation::type_id<Object>();
+                bytes_ = footprint();
+                instrumentation::record_allocation(type_, bytes_);
+#endif
+            }
+
+            // Destroy the managed object
+            virtual void dispose() noexcept = 0;
+
+            // Free the memory occupied by the control block
+            virtual void destroy() noexcept = 0;
+
+        private:
+            typename Policy::counts counts_;
+            [[no_unique_address]] typename link_of<Policy>::type link_{};
+#ifdef MP_CPP_HW1_INSTRUMENT
+            std::uint32_t type_ = 0;
+            std::size_t bytes_ = 0;
+#endif
+        };
+
+        // T lists the shared_ptrs it holds with a `void trace(tracer<Policy> &) const` member
+        template<typename T, typename Policy>
+        concept traceable = requires(const T &object, tracer<Policy> &visit) { object.trace(visit); };
+
+        // The deleter of an adopted array knows its length: extent() is the number of innermost elements from the
+        // adopted pointer on, as for the arrays map_shared maps (mapped_array.h)
+        template<typename Deleter>
+        concept sized_deleter = requires(const Deleter &deleter) {
+            { deleter.extent() } -> std::convertible_to<std::size_t>;
+        };
+
+        template<typename Alloc, typename U>
+        using rebind_alloc = typename std::allocator_traits<Alloc>::template rebind_alloc<U>;
+
+        // The allocator make_shared and the constructors without an explicit allocator use
+        template<typename T>
+        using default_allocator = std::allocator<std::remove_cv_t<std::remove_all_extents_t<T>>>;
+
+        // Control block for an object allocated by the user and passed to shared_ptr by pointer.
+        // Stateless deleters and allocators take no space in the block
+        template<typename Y, typename Deleter, typename Alloc, typename Policy>
+        class pointer_control_block final : public control_block_base<Policy> {
+        public:
+            using block_allocator = rebind_alloc<Alloc, pointer_control_block>;
+
+            pointer_control_block(Y *ptr, Deleter &&deleter, const Alloc &alloc) noexcept
+                    : ptr_(ptr), deleter_(std::move(deleter)), alloc_(alloc) {
+                this->template created<Y>();
+            }
+
+            [[nodiscard]] std::size_t elements_from(const void *element) const noexcept override {
+                if constexpr (sized_deleter<Deleter>) {
+                    using elementary_type = std::remove_all_extents_t<Y>;
+                    // Compared as integers: `element` may point anywhere
+                    auto first = reinterpret_cast<std::uintptr_t>(ptr_);
+                    auto position = reinterpret_cast<std::uintptr_t>(element);
+                    std::size_t count = deleter_.extent();
+                    if (position < first || position >= first + count * sizeof(elementary_type)) {
+                        return 0;
+                    }
+                    return count - (position - first) / sizeof(elementary_type);
+                } else {
+                    return control_block_base<Policy>::elements_from(element);
+                }
+            }
+
+            [[nodiscard]] std::size_t footprint() const noexcept override {
+                // The length of an adopted array is not known, so only its first element is counted
+                if constexpr (is_type_complete_v<Y>) {
+                    return sizeof(pointer_control_block) + sizeof(Y);
+                } else {
+                    return sizeof(pointer_control_block);
+                }
+            }
+
+            bool trace(tracer<Policy> &visit) noexcept override {
+                if constexpr (traceable<Y, Policy>) {
+                    std::as_const(*ptr_).trace(visit);
+                    return true;
+                } else {
+                    return control_block_base<Policy>::trace(visit);
+                }
+            }
+
+        private:
+            Y *ptr_;
+            [[no_unique_address]] Deleter deleter_;
+            [[no_unique_address]] block_allocator alloc_;
+
+            void dispose() noexcept override {
+                deleter_(ptr_);
+            }
+
+            void destroy() noexcept override {
+                block_allocator alloc(std::move(alloc_));
+                this->~pointer_control_block();
+                std::allocator_traits<block_allocator>::deallocate(alloc, this, 1);
+            }
+        };
+
+        // Allocates a control block for the given pointer, destroying the object if the allocation fails
+        template<typename Policy, typename Y, typename Deleter, typename Alloc>
+        control_block_base<Policy> *make_pointer_block(Y *ptr, Deleter deleter, const Alloc &alloc) {
+            using block_type = pointer_control_block<Y, Deleter, Alloc, Policy>;
+            typename block_type::block_allocator block_alloc(alloc);
+            try {
+                auto memory = std::allocator_traits<typename block_type::block_allocator>::allocate(block_alloc, 1);
+                return ::new (static_cast<void *>(memory)) block_type(ptr, std::move(deleter), alloc);
+            } catch (...) {
+                deleter(ptr);
+                throw;
+            }
+        }
+
+        // Selects the _for_overwrite constructors, which default-initialise the object or the elements
+        struct for_overwrite_t {
+            explicit for_overwrite_t() = default;
+        };
+
+        inline constexpr for_overwrite_t for_overwrite{};
+
+        // Control block of make_shared and allocate_shared: the object lives right after the counters in the same
+        // allocation and is constructed and destroyed through the allocator
+        template<typename T, typename Alloc, typename Policy>
+        class inplace_control_block final : public control_block_base<Policy> {
+            using object_type = std::remove_cv_t<T>;
+            using object_allocator = rebind_alloc<Alloc, object_type>;
+        public:
+            using block_allocator = rebind_alloc<Alloc, inplace_control_block>;
+
+            template<typename... Args>
+            explicit inplace_control_block(const Alloc &alloc, Args &&... args) : alloc_(alloc) {
+                object_allocator object_alloc(alloc_);
+                std::allocator_traits<object_allocator>::construct(object_alloc, object(),
+                                                                   std::forward<Args>(args)...);
+                this->template created<object_type>();
+            }
+
+            // Default-initialises the object, like `new T` does, instead of value-initialising it
+            inplace_control_block(const Alloc &alloc, for_overwrite_t) : alloc_(alloc) {
+                ::new (static_cast<void *>(storage_)) object_type;
+                this->template created<object_type>();
+            }
+
+            T *get() noexcept {
+                return object();
+            }
+
+            [[nodiscard]] std::size_t footprint() const noexcept override {
+                return sizeof(inplace_control_block);
+            }
+
+            bool trace(tracer<Policy> &visit) noexcept override {
+                if constexpr (traceable<object_type, Policy>) {
+                    std::as_const(*object()).trace(visit);
+                    return true;
+                } else {
+                    return control_block_base<Policy>::trace(visit);
+                }
+            }
+
+        private:
+            [[no_unique_address]] block_allocator alloc_;
+            alignas(T) unsigned char storage_[sizeof(T)];
+
+            object_type *object() noexcept {
+                return std::launder(reinterpret_cast<object_type *>(storage_));
+            }
+
+            void dispose() noexcept override {
+                object_allocator object_alloc(alloc_);
+                std::allocator_traits<object_allocator>::destroy(object_alloc, object());
+            }
+
+            void destroy() noexcept override {
+                block_allocator alloc(std::move(alloc_));
+                this->~inplace_control_block();
+                std::allocator_traits<block_allocator>::deallocate(alloc, this, 1);
+            }
+        };
+
+        // Allocates an inplace block and constructs the object in it
+        template<typename T, typename Policy, typename Alloc, typename... Args>
+        inplace_control_block<T, Alloc, Policy> *make_inplace_block(const Alloc &alloc, Args &&... args) {
+            using block_type = inplace_control_block<T, Alloc, Policy>;
+            using traits = std::allocator_traits<typename block_type::block_allocator>;
+            typename block_type::block_allocator block_alloc(alloc);
+            auto memory = traits::allocate(block_alloc, 1);
+            try {
+                return ::new (static_cast<void *>(memory)) block_type(alloc, std::forward<Args>(args)...);
+            } catch (...) {
+                traits::deallocate(block_alloc, memory, 1);
+                throw;
+            }
+        }
+
+        // Destroy `count` elements starting from `first` in reverse order, like the destruction of a built-in array
+        template<typename Alloc, typename E>
+        void destroy_elements(Alloc &alloc, E *first, std::size_t count) noexcept {
+            while (count > 0) {
+                std::allocator_traits<Alloc>::destroy(alloc, first + --count);
+            }
+        }
+
+        // How an array block destroys its elements when the last owner goes: here on the calling thread
+        struct serial_destroy {
+            template<typename Alloc, typename E>
+            void operator()(Alloc &alloc, E *first, std::size_t count) const noexcept {
+                destroy_elements(alloc, first, count);
+            }
+        };
+
+        // Control block of make_shared for arrays: a header followed by `count` elements in one allocation.
+        // E is the innermost element type, so multidimensional arrays are stored as a flat sequence of E.
+        // The elements are destroyed by Destroy, a stateless function object like serial_destroy
+        template<typename E, typename Alloc, typename Policy, typename Destroy = serial_destroy>
+        class inplace_array_control_block final : public control_block_base<Policy> {
+            static constexpr std::size_t alignment = alignof(E) > alignof(control_block_base<Policy>)
+                                                     ? alignof(E) : alignof(control_block_base<Policy>);
+
+            // The unit the block is allocated in, so that the allocator provides the alignment of both parts
+            struct alignas(alignment) storage_unit {
+                unsigned char bytes[alignment];
+            };
+
+            using storage_allocator = rebind_alloc<Alloc, storage_unit>;
+        public:
+            using element_allocator = rebind_alloc<Alloc, E>;
+
+            // Allocate a block with room for `count` elements which are left uninitialised
+            static inplace_array_control_block *allocate(const Alloc &alloc, std::size_t count) {
+                if (count > (max_bytes - data_offset() - alignment) / sizeof(E)) {
+                    throw std::bad_array_new_length();
+                }
+                storage_allocator storage_alloc(alloc);
+                auto memory = std::allocator_traits<storage_allocator>::allocate(storage_alloc, units(count));
+                return ::new (static_cast<void *>(memory)) inplace_array_control_block(alloc, count);
+            }
+
+            // Free a block whose elements were never constructed
+            void deallocate() noexcept {
+                storage_allocator storage_alloc(std::move(alloc_));
+                std::size_t count = count_;
+                this->~inplace_array_control_block();
+                std::allocator_traits<storage_allocator>::deallocate(storage_alloc, reinterpret_cast<storage_unit *>(this),
+                                                                     units(count));
+            }
+
+            E *data() noexcept {
+                return std::launder(reinterpret_cast<E *>(reinterpret_cast<unsigned char *>(this) + data_offset()));
+            }
+
+            [[nodiscard]] std::size_t size() const noexcept {
+                return count_;
+            }
+
+            [[nodiscard]] std::size_t footprint() const noexcept override {
+                return units(count_) * alignment;
+            }
+
+            [[nodiscard]] std::size_t elements_from(const void *element) const noexcept override {
+                // Compared as integers: `element` may point anywhere
+                auto first = reinterpret_cast<std::uintptr_t>(this) + data_offset();
+                auto position = reinterpret_cast<std::uintptr_t>(element);
+                if (position < first || position >= first + count_ * sizeof(E)) {
+                    return 0;
+                }
+                return count_ - (position - first) / sizeof(E);
+            }
+
+            bool trace(tracer<Policy> &visit) noexcept override {
+                if constexpr (traceable<E, Policy>) {
+                    for (std::size_t i = 0; i < count_; ++i) {
+                        std::as_const(data()[i]).trace(visit);
+                    }
+                    return true;
+                } else {
+                    return control_block_base<Policy>::trace(visit);
+                }
+            }
+
+        private:
+            static constexpr std::size_t max_bytes = static_cast<std::size_t>(-1);
+
+            [[no_unique_address]] storage_allocator alloc_;
+            std::size_t count_;
+
+            inplace_array_control_block(const Alloc &alloc, std::size_t count) noexcept : alloc_(alloc), count_(count) {
+                this->template created<E[]>();
+            }
+
+            static constexpr std::size_t data_offset() noexcept {
+                return (sizeof(inplace_array_control_block) + alignof(E) - 1) / alignof(E) * alignof(E);
+            }
+
+            static constexpr std::size_t units(std::size_t count) noexcept {
+                return (data_offset() + count * sizeof(E) + alignment - 1) / alignment;
+            }
+
+            void dispose() noexcept override {
+                element_allocator element_alloc(alloc_);
+                Destroy()(element_alloc, data(), count_);
+            }
+
+            void destroy() noexcept override {
+                deallocate();
+            }
+        };
+
+        // The allocator has no construct() of its own for E, so elements may be built by the uninitialized_*
+        // algorithms, which write trivial types in bulk (memset, vectorised fills)
+        template<typename Alloc, typename E>
+        concept constructs_in_place = !requires(Alloc &alloc, E *ptr) { alloc.construct(ptr); } &&
+                                      !requires(Alloc &alloc, E *ptr, const E &value) { alloc.construct(ptr, value); };
+
+        // Copy the first `row` elements over the rest of the `size` ones. The copied part doubles until it fills
+        // a block that stays in cache, which is then copied over and over
+        template<typename E>
+        void repeat_row(E *data, std::size_t size, std::size_t row) noexcept {
+            constexpr std::size_t block_bytes = 16 * 1024;
+            std::size_t block = std::max(row, block_bytes / sizeof(E) / row * row);
+            for (std::size_t filled = row; filled < size;) {
+                std::size_t chunk = std::min({filled, block, size - filled});
+                std::memcpy(data + filled, data, chunk * sizeof(E));
+                filled += chunk;
+            }
+        }
+
+        // Construct `count` rows of `row` elements each at `data`, every row copied from `pattern`, or every element
+        // value-initialised if `pattern` is null. Nothing is left constructed if an exception is thrown
+        template<typename Alloc, typename E>
+        void construct_elements(Alloc &alloc, E *data, std::size_t count, std::size_t row, const E *pattern) {
+            std::size_t size = count * row;
+            if constexpr (constructs_in_place<Alloc, E>) {
+                if (!pattern) {
+                    std::uninitialized_value_construct_n(data, size);
+                    return;
+                }
+                if (row == 1) {
+                    std::uninitialized_fill_n(data, size, *pattern);
+                    return;
+                }
+                if constexpr (std::is_trivially_copyable_v<E>) {
+                    if (size > 0) {
+                        std::memcpy(data, pattern, row * sizeof(E));
+                        repeat_row(data, size, row);
+                    }
+                    return;
+                }
+            }
+            using traits = std::allocator_traits<Alloc>;
+            std::size_t constructed = 0;
+            try {
+                for (; constructed < size; ++constructed) {
+                    if (pattern) {
+                        traits::construct(alloc, data + constructed, pattern[constructed % row]);
+                    } else {
+                        traits::construct(alloc, data + constructed);
+                    }
+                }
+            } catch (...) {
+                destroy_elements(alloc, data, constructed);
+                throw;
+            }
+        }
+
+        // Allocate an array block for `count` elements of T (which may itself be an array)
+        template<typename T, typename Policy, typename Destroy = serial_destroy, typename Alloc>
+        auto allocate_array_block(const Alloc &alloc, std::size_t count) {
+            using elementary_type = std::remove_cv_t<std::remove_all_extents_t<T>>;
+            using block_type = inplace_array_control_block<elementary_type, Alloc, Policy, Destroy>;
+            constexpr std::size_t row = sizeof(T) / sizeof(elementary_type);
+            if (count > static_cast<std::size_t>(-1) / row) {
+                throw std::bad_array_new_length();
+            }
+            return block_type::allocate(alloc, count * row);
+        }
+
+        // Build an array block of `count` elements of T (which may itself be an array) with every element
+        // constructed by copying `u`, or value-initialised if `u` is null
+        template<typename T, typename Policy, typename Alloc>
+        auto make_array_block(const Alloc &alloc, std::size_t count, const T *u = nullptr) {
+            using elementary_type = std::remove_cv_t<std::remove_all_extents_t<T>>;
+            constexpr std::size_t row = sizeof(T) / sizeof(elementary_type);
+            auto block = allocate_array_block<T, Policy>(alloc, count);
+            using element_allocator = typename std::remove_pointer_t<decltype(block)>::element_allocator;
+            element_allocator element_alloc(alloc);
+            try {
+                construct_elements(element_alloc, block->data(), count, row,
+                                   reinterpret_cast<const elementary_type *>(u));
+            } catch (...) {
+                block->deallocate();
+                throw;
+            }
+            return block;
+        }
+
+        // Same as above, but the elements are default-initialised: trivial ones are left as the allocator gave them
+        template<typename T, typename Policy, typename Alloc>
+        auto make_array_block(const Alloc &alloc, std::size_t count, for_overwrite_t) {
+            auto block = allocate_array_block<T, Policy>(alloc, count);
+            try {
+                std::uninitialized_default_construct_n(block->data(), block->size());
+            } catch (...) {
+                block->deallocate();
+                throw;
+            }
+            return block;
+        }
+
+        // Build an array block of `count` objects of T, every one constructed from the same `args`, which are
+        // therefore passed as lvalues. The use count starts at `count`: one owner per object
+        template<typename T, typename Policy, typename Alloc, typename... Args>
+        auto make_batch_block(const Alloc &alloc, std::size_t count, Args &&... args) {
+            auto block = allocate_array_block<T, Policy>(alloc, count);
+            using element_allocator = typename std::remove_pointer_t<decltype(block)>::element_allocator;
+            element_allocator element_alloc(alloc);
+            std::size_t constructed = 0;
+            try {
+                for (; constructed < count; ++constructed) {
+                    std::allocator_traits<element_allocator>::construct(element_alloc, block->data() + constructed,
+                                                                        args...);
+                }
+            } catch (...) {
+                destroy_elements(element_alloc, block->data(), constructed);
+                block->deallocate();
+                throw;
+            }
+            block->add_refs(count - 1);
+            return block;
+        }
+
+        // Y * can be adopted by shared_ptr<T>: it points to T or to a class derived from it,
+        // or, for arrays, to an array whose elements convert to those of T
+        template<typename Y, typename T>
+        concept adoptable = std::is_array_v<T> && (std::is_convertible_v<Y(*)[], T *> ||
+                                                   std::is_convertible_v<Y(*)[sizeof(T) /
+                                                                               sizeof(std::remove_extent_t<T>)], T *>) ||
+                            !std::is_array_v<T> && std::is_convertible_v<Y *, T *>;
+
+        // shared_ptr<Y> converts to shared_ptr<T>: Y * converts to T *, or Y is U[N] and T is U[]
+        template<typename Y, typename T>
+        concept compatible = std::is_convertible_v<Y *, T *> ||
+                             std::is_bounded_array_v<Y> && std::is_same_v<std::remove_cv_t<T>, std::remove_extent_t<Y>[]>;
+
+        struct shared_ptr_access;
+    }  // namespace detail
+
+    template<typename T, count_policy Policy = atomic_count>
+    class weak_ptr;
+
+    template<typename T, count_policy Policy = atomic_count>
+    class enable_shared_from_this;
+
+    namespace detail {
+        // Y derives from enable_shared_from_this with the same policy, once and publicly. Decided at compile time,
+        // so taking ownership of objects of other types costs nothing
+        template<typename Y, typename Policy>
+        concept shares_from_this = requires { typename Y::shared_from_this_type; } &&
+                                   std::is_convertible_v<Y *, const enable_shared_from_this<
+                                           typename Y::shared_from_this_type, Policy> *>;
+
+        // Give an object deriving from enable_shared_from_this a weak reference to the control block that has just
+        // taken ownership of it. Does nothing for other objects
+        template<typename Policy, typename Y>
+        void enable_shared_from(Y *obj, control_block_base<Policy> *ctrl) noexcept;
+    }  // namespace detail
+
+    // T is the type of the managed object or array, Policy selects how the reference count is updated:
+    // atomic_count (the default) can be shared between threads, local_count is for single-threaded code
+    template<typename T, count_policy Policy = atomic_count>
     class shared_ptr {
-        using element_type = std::remove_reference_t<std::remove_extent_t<T>>;
     public:
+        using element_type = std::remove_reference_t<std::remove_extent_t<T>>;
+
         // Constructs an empty shared_ptr
         constexpr shared_ptr() noexcept;
 
@@ -23,20 +836,46 @@ namespace smart_pointer {
 
         // Construct a shared_ptr that manages the given object or array
         template<typename Y>
-            requires (std::is_array_v<T> && (std::is_convertible_v<Y(*)[], T *> ||
-                                            std::is_convertible_v<Y(*)[sizeof(T) /
-                                                                        sizeof(std::remove_extent_t<T>)], T *>) ||
-                     !std::is_array_v<T> && std::is_convertible_v<Y *, T *>)
+            requires detail::adoptable<Y, T>
         explicit shared_ptr(Y *obj);
 
+        // Construct a shared_ptr that manages the given object or array and destroys it with the deleter
+        template<typename Y, typename Deleter>
+            requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+        shared_ptr(Y *obj, Deleter deleter);
+
+        // Same as above, but the control block is allocated with the given allocator
+        template<typename Y, typename Deleter, typename Alloc>
+            requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+        shared_ptr(Y *obj, Deleter deleter, Alloc alloc);
+
         // Copy constructor
-        shared_ptr(const shared_ptr &other);
+        constexpr shared_ptr(const shared_ptr &other) noexcept;
 
         // Move constructor
-        shared_ptr(shared_ptr &&other) noexcept;
+        constexpr shared_ptr(shared_ptr &&other) noexcept;
 
-        // Destructor
-        ~shared_ptr();
+        // Converting copy constructor: shares ownership with a shared_ptr to a derived class (or a bounded array)
+        template<typename Y>
+            requires detail::compatible<Y, T>
+        shared_ptr(const shared_ptr<Y, Policy> &other) noexcept;
+
+        // Converting move constructor
+        template<typename Y>
+            requires detail::compatible<Y, T>
+        shared_ptr(shared_ptr<Y, Policy> &&other) noexcept;
+
+        // Aliasing constructor: shares ownership with `owner` but points to `obj`, usually a member or an element of
+        // the object `owner` manages. No control block is allocated
+        template<typename Y>
+        shared_ptr(const shared_ptr<Y, Policy> &owner, element_type *obj) noexcept;
+
+        // Same as above, but takes over the reference held by `owner`
+        template<typename Y>
+        shared_ptr(shared_ptr<Y, Policy> &&owner, element_type *obj) noexcept;
+
+        // Destructor. An empty shared_ptr owns nothing, so it can also be destroyed in a constant expression
+        constexpr ~shared_ptr();
 
         // Copy assignment operator
         shared_ptr &operator=(const shared_ptr &other);
@@ -44,6 +883,16 @@ namespace smart_pointer {
         // Move assignment operator
         shared_ptr &operator=(shared_ptr &&other) noexcept;
 
+        // Converting copy assignment operator
+        template<typename Y>
+            requires detail::compatible<Y, T>
+        shared_ptr &operator=(const shared_ptr<Y, Policy> &other) noexcept;
+
+        // Converting move assignment operator
+        template<typename Y>
+            requires detail::compatible<Y, T>
+        shared_ptr &operator=(shared_ptr<Y, Policy> &&other) noexcept;
+
         // Dereference operator
         element_type &operator*() const;
 
@@ -62,244 +911,812 @@ namespace smart_pointer {
             return obj_[idx];
         }
 
-        // Get the number of owners of the managed object
-        [[nodiscard]] std::size_t use_count() const;
+#ifndef NDEBUG
+        // Index operator that throws std::out_of_range past the end of the array. Debug builds only: release
+        // builds are meant to use operator[]
+        element_type &at(std::size_t idx) const requires std::is_array_v<T>;
+#endif
+
+        // Number of elements of the array: N for T[N], and for T[] the number make_shared created counted from
+        // get(), so it stays right for aliases into the array. 0 for an empty shared_ptr and for arrays adopted
+        // by pointer, whose length is not known, unless their deleter reports it through extent() (the arrays of
+        // map_shared do). begin(), end() and as_span() follow it. Costs a virtual call for T[] and nothing for T[N]
+        [[nodiscard]] constexpr std::size_t size() const noexcept requires std::is_array_v<T>;
+
+        // Iterators over the elements of the array
+        element_type *begin() const noexcept requires std::is_array_v<T> {
+            return obj_;
+        }
+
+        element_type *end() const noexcept requires std::is_array_v<T> {
+            return obj_ + size();
+        }
+
+        // View of the elements of the array, with a static extent for T[N] (so shared_ptr<T[N]> must not be empty).
+        // The span does not own the elements, so the shared_ptr (or a copy) must outlive it
+        auto as_span() const noexcept requires std::is_array_v<T> {
+            return std::span<element_type, std::is_bounded_array_v<T> ? std::extent_v<T> : std::dynamic_extent>(
+                    obj_, size());
+        }
 
-        // Release ownership of the managed object
-        void reset() requires (!std::is_array_v<T>);
+        // Get the number of owners of the managed object
+        [[nodiscard]] constexpr std::size_t use_count() const noexcept;
 
-        // Release ownership of the managed array
-        void reset() requires std::is_array_v<T>;
+        // Release ownership of the managed object or array
+        constexpr void reset() noexcept;
 
         // Release ownership of the managed object and take ownership of the given object
         void reset(std::remove_extent_t<T> *obj);
 
+        // Release ownership of the managed object and take ownership of the given object with a custom deleter
+        template<typename Y, typename Deleter>
+            requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+        void reset(Y *obj, Deleter deleter);
+
+        // Same as above, but the control block is allocated with the given allocator
+        template<typename Y, typename Deleter, typename Alloc>
+            requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+        void reset(Y *obj, Deleter deleter, Alloc alloc);
+
         // Get a raw pointer to the managed object
-        element_type *get() const;
+        constexpr element_type *get() const noexcept;
 
     private:
+        friend struct detail::shared_ptr_access;
+
+        template<typename, count_policy>
+        friend class shared_ptr;
+
+        template<typename, count_policy>
+        friend class weak_ptr;
+
+        using default_deleter = std::conditional_t<std::is_array_v<T>,
+                std::default_delete<std::remove_extent_t<T>[]>, std::default_delete<T>>;
+
+        // Both are null for an empty shared_ptr, which therefore never allocates
         element_type *obj_;
-        std::size_t *ref_count_;
+        detail::control_block_base<Policy> *ctrl_;
 
-        void release() noexcept requires std::is_array_v<T>;
+        // Adopt an already counted control block (used by make_shared)
+        shared_ptr(element_type *obj, detail::control_block_base<Policy> *ctrl) noexcept : obj_(obj), ctrl_(ctrl) {}
 
-        void release() noexcept requires (!std::is_array_v<T>);
+        constexpr void release() noexcept;
     };
 
+    // shared_ptr for objects that never leave one thread: copies do not pay for atomic operations
     template<typename T>
-    void shared_ptr<T>::reset(std::remove_extent_t<T> *obj) {
+    using local_shared_ptr = shared_ptr<T, local_count>;
+
+    namespace detail {
+        // Gives the factory functions access to the private adopting constructor of shared_ptr, atomic_shared_ptr
+        // to the control block for comparisons, and compact_shared_ptr to the reference it takes over
+        struct shared_ptr_access {
+            template<typename T, typename Policy>
+            static shared_ptr<T, Policy> make(typename shared_ptr<T, Policy>::element_type *obj,
+                                              control_block_base<Policy> *ctrl) noexcept {
+                return shared_ptr<T, Policy>(obj, ctrl);
+            }
+
+            template<typename T, typename Policy>
+            static control_block_base<Policy> *control_block(const shared_ptr<T, Policy> &ptr) noexcept {
+                return ptr.ctrl_;
+            }
+
+            // Empty the pointer without releasing its reference, which the caller takes over
+            template<typename T, typename Policy>
+            static control_block_base<Policy> *take(shared_ptr<T, Policy> &ptr) noexcept {
+                ptr.obj_ = nullptr;
+                return std::exchange(ptr.ctrl_, nullptr);
+            }
+        };
+    }  // namespace detail
+
+    // Handed to the trace() member of objects managed with a policy that collects cycles (cyclic_count.h), which
+    // calls it with every shared_ptr the object holds
+    template<count_policy Policy>
+    class tracer {
+    public:
+        template<typename U>
+        void operator()(const shared_ptr<U, Policy> &edge) noexcept {
+            if (auto block = detail::shared_ptr_access::control_block(edge)) {
+                visit(block);
+            }
+        }
+
+    protected:
+        ~tracer() = default;
+
+        virtual void visit(detail::control_block_base<Policy> *block) noexcept = 0;
+    };
+
+    template<typename T, count_policy Policy>
+    void shared_ptr<T, Policy>::reset(std::remove_extent_t<T> *obj) {
         if (obj_ == obj) {
             return;
         }
+        auto ctrl = detail::make_pointer_block<Policy>(obj, default_deleter(), detail::default_allocator<element_type>());
         release();
         obj_ = obj;
-        ref_count_ = new std::size_t(1);
+        ctrl_ = ctrl;
+        detail::enable_shared_from(obj, ctrl_);
     }
 
-    template<typename T>
-    void shared_ptr<T>::release() noexcept requires (!std::is_array_v<T>) {
-        if (!ref_count_) {
-            return;
-        }
-        if (*ref_count_ > 0) {
-            --*ref_count_;
-        }
-        if (*ref_count_ == 0) {
-            delete obj_;
-            obj_ = nullptr;
-            delete ref_count_;
-            ref_count_ = nullptr;
-        }
+    template<typename T, count_policy Policy>
+    template<typename Y, typename Deleter>
+        requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+    void shared_ptr<T, Policy>::reset(Y *obj, Deleter deleter) {
+        *this = shared_ptr(obj, std::move(deleter));
     }
 
-    template<typename T>
-    void shared_ptr<T>::release() noexcept requires std::is_array_v<T> {
-        if (!ref_count_) {
-            return;
-        }
-        if (*ref_count_ > 0) {
-            --*ref_count_;
-        }
-        if (*ref_count_ == 0) {
-            delete[] obj_;
-            obj_ = nullptr;
-            delete ref_count_;
-            ref_count_ = nullptr;
+    template<typename T, count_policy Policy>
+    template<typename Y, typename Deleter, typename Alloc>
+        requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+    void shared_ptr<T, Policy>::reset(Y *obj, Deleter deleter, Alloc alloc) {
+        *this = shared_ptr(obj, std::move(deleter), std::move(alloc));
+    }
+
+    template<typename T, count_policy Policy>
+    constexpr void shared_ptr<T, Policy>::release() noexcept {
+        if (ctrl_) {
+            ctrl_->release();
         }
+        obj_ = nullptr;
+        ctrl_ = nullptr;
     }
 
-    template<typename T>
-    constexpr shared_ptr<T>::shared_ptr(std::nullptr_t) noexcept : obj_(nullptr), ref_count_(new std::size_t(0)) {}
+    template<typename T, count_policy Policy>
+    constexpr shared_ptr<T, Policy>::shared_ptr(std::nullptr_t) noexcept : obj_(nullptr), ctrl_(nullptr) {}
 
-    template<typename T>
-    constexpr shared_ptr<T>::shared_ptr() noexcept : obj_(nullptr), ref_count_(new std::size_t(0)) {}
+    template<typename T, count_policy Policy>
+    constexpr shared_ptr<T, Policy>::shared_ptr() noexcept : obj_(nullptr), ctrl_(nullptr) {}
 
-    template<typename T>
+    template<typename T, count_policy Policy>
     template<typename Y>
-        requires (std::is_array_v<T> && (std::is_convertible_v<Y(*)[], T *> ||
-                                        std::is_convertible_v<Y(*)[sizeof(T) /
-                                                                    sizeof(std::remove_extent_t<T>)], T *>) ||
-                 !std::is_array_v<T> && std::is_convertible_v<Y *, T *>)
-    shared_ptr<T>::shared_ptr(Y *obj) : obj_(obj), ref_count_(new std::size_t(1)) {}
+        requires detail::adoptable<Y, T>
+    shared_ptr<T, Policy>::shared_ptr(Y *obj)
+            : shared_ptr(obj, std::conditional_t<std::is_array_v<T>, std::default_delete<Y[]>,
+                                                 std::default_delete<Y>>()) {}
 
-    template<typename T>
-    shared_ptr<T>::shared_ptr(const shared_ptr &other) : obj_(other.obj_) {
-        if (obj_) {
-            ref_count_ = other.ref_count_;
-            ++*ref_count_;
-        } else {
-            ref_count_ = new std::size_t(0);
+    template<typename T, count_policy Policy>
+    template<typename Y, typename Deleter>
+        requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+    shared_ptr<T, Policy>::shared_ptr(Y *obj, Deleter deleter)
+            : shared_ptr(obj, std::move(deleter), detail::default_allocator<Y>()) {}
+
+    template<typename T, count_policy Policy>
+    template<typename Y, typename Deleter, typename Alloc>
+        requires detail::adoptable<Y, T> && std::is_invocable_v<Deleter &, Y *>
+    shared_ptr<T, Policy>::shared_ptr(Y *obj, Deleter deleter, Alloc alloc)
+            : obj_(obj), ctrl_(detail::make_pointer_block<Policy>(obj, std::move(deleter), alloc)) {
+        detail::enable_shared_from(obj, ctrl_);
+    }
+
+    template<typename T, count_policy Policy>
+    constexpr shared_ptr<T, Policy>::shared_ptr(const shared_ptr &other) noexcept : obj_(other.obj_), ctrl_(other.ctrl_) {
+        if (ctrl_) {
+            ctrl_->add_ref();
         }
     }
 
-    template<typename T>
-    shared_ptr<T>::shared_ptr(shared_ptr &&other) noexcept : obj_(other.obj_), ref_count_(other.ref_count_) {
+    template<typename T, count_policy Policy>
+    constexpr shared_ptr<T, Policy>::shared_ptr(shared_ptr &&other) noexcept : obj_(other.obj_), ctrl_(other.ctrl_) {
         other.obj_ = nullptr;
-        other.ref_count_ = nullptr;
+        other.ctrl_ = nullptr;
+        if (ctrl_) {
+            ctrl_->moved();
+        }
     }
 
-    template<typename T>
-    shared_ptr<T>::~shared_ptr() {
-        release();
-        if (ref_count_ && *ref_count_ == 0) {
-            delete ref_count_;
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires detail::compatible<Y, T>
+    shared_ptr<T, Policy>::shared_ptr(const shared_ptr<Y, Policy> &other) noexcept
+            : obj_(other.obj_), ctrl_(other.ctrl_) {
+        if (ctrl_) {
+            ctrl_->add_ref();
         }
     }
 
-    template<typename T>
-    shared_ptr<T> &shared_ptr<T>::operator=(const shared_ptr<T> &other) {
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires detail::compatible<Y, T>
+    shared_ptr<T, Policy>::shared_ptr(shared_ptr<Y, Policy> &&other) noexcept : obj_(other.obj_), ctrl_(other.ctrl_) {
+        other.obj_ = nullptr;
+        other.ctrl_ = nullptr;
+        if (ctrl_) {
+            ctrl_->moved();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    template<typename Y>
+    shared_ptr<T, Policy>::shared_ptr(const shared_ptr<Y, Policy> &owner, element_type *obj) noexcept
+            : obj_(obj), ctrl_(owner.ctrl_) {
+        if (ctrl_) {
+            ctrl_->add_ref();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    template<typename Y>
+    shared_ptr<T, Policy>::shared_ptr(shared_ptr<Y, Policy> &&owner, element_type *obj) noexcept
+            : obj_(obj), ctrl_(owner.ctrl_) {
+        owner.obj_ = nullptr;
+        owner.ctrl_ = nullptr;
+        if (ctrl_) {
+            ctrl_->moved();
+        }
+    }
+
+    template<typename T, count_policy Policy>
+    constexpr shared_ptr<T, Policy>::~shared_ptr() {
+        release();
+    }
+
+    template<typename T, count_policy Policy>
+    shared_ptr<T, Policy> &shared_ptr<T, Policy>::operator=(const shared_ptr<T, Policy> &other) {
         if (this != &other) {
-            release();
-            obj_ = other.obj_;
-            if (obj_) {
-                ref_count_ = other.ref_count_;
-                ++*ref_count_;
-            } else {
-                ref_count_ = new std::size_t(0);
+            // Take the new reference first: `other` may be owned by the object we are about to release
+            if (other.ctrl_) {
+                other.ctrl_->add_ref();
             }
+            auto obj = other.obj_;
+            auto ctrl = other.ctrl_;
+            release();
+            obj_ = obj;
+            ctrl_ = ctrl;
         }
         return *this;
     }
 
-    template<typename T>
-    shared_ptr<T> &shared_ptr<T>::operator=(shared_ptr<T> &&other) noexcept {
+    template<typename T, count_policy Policy>
+    shared_ptr<T, Policy> &shared_ptr<T, Policy>::operator=(shared_ptr<T, Policy> &&other) noexcept {
         if (this != &other) {
-            release();
-            obj_ = other.obj_;
-            ref_count_ = other.ref_count_;
+            auto obj = other.obj_;
+            auto ctrl = other.ctrl_;
             other.obj_ = nullptr;
-            other.ref_count_ = nullptr;
+            other.ctrl_ = nullptr;
+            release();
+            obj_ = obj;
+            ctrl_ = ctrl;
+            if (ctrl_) {
+                ctrl_->moved();
+            }
         }
         return *this;
     }
 
-    template<typename T>
-    shared_ptr<T>::element_type &shared_ptr<T>::operator*() const {
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires detail::compatible<Y, T>
+    shared_ptr<T, Policy> &shared_ptr<T, Policy>::operator=(const shared_ptr<Y, Policy> &other) noexcept {
+        // Copy first: `other` may be owned by the object we are about to release
+        return *this = shared_ptr(other);
+    }
+
+    template<typename T, count_policy Policy>
+    template<typename Y>
+        requires detail::compatible<Y, T>
+    shared_ptr<T, Policy> &shared_ptr<T, Policy>::operator=(shared_ptr<Y, Policy> &&other) noexcept {
+        return *this = shared_ptr(std::move(other));
+    }
+
+    template<typename T, count_policy Policy>
+    shared_ptr<T, Policy>::element_type &shared_ptr<T, Policy>::operator*() const {
         return *obj_;
     }
 
-    template<typename T>
-    std::size_t shared_ptr<T>::use_count() const {
-        return *ref_count_;
+    template<typename T, count_policy Policy>
+    constexpr std::size_t shared_ptr<T, Policy>::use_count() const noexcept {
+        return ctrl_ ? ctrl_->use_count() : 0;
     }
 
-    template<typename T>
-    void shared_ptr<T>::reset() requires (!std::is_array_v<T>) {
-        if (ref_count_ && *ref_count_ == 1) {
-            delete obj_;
+    template<typename T, count_policy Policy>
+    constexpr void shared_ptr<T, Policy>::reset() noexcept {
+        release();
+    }
+
+    template<typename T, count_policy Policy>
+    constexpr shared_ptr<T, Policy>::element_type *shared_ptr<T, Policy>::get() const noexcept {
+        return obj_;
+    }
+
+#ifndef NDEBUG
+    template<typename T, count_policy Policy>
+    shared_ptr<T, Policy>::element_type &shared_ptr<T, Policy>::at(std::size_t idx) const
+        requires std::is_array_v<T> {
+        if (idx >= size()) {
+            throw std::out_of_range("shared_ptr::at: index out of range");
         }
-        obj_ = nullptr;
-        --*ref_count_;
-        if (*ref_count_ == 0) {
-            return;
+        return obj_[idx];
+    }
+#endif
+
+    template<typename T, count_policy Policy>
+    constexpr std::size_t shared_ptr<T, Policy>::size() const noexcept requires std::is_array_v<T> {
+        if (!obj_) {
+            return 0;
+        }
+        if constexpr (std::is_bounded_array_v<T>) {
+            return std::extent_v<T>;
+        } else {
+            // The block counts the innermost elements; for T[][K] every element is a row of K of them
+            using elementary_type = std::remove_all_extents_t<T>;
+            return ctrl_ ? ctrl_->elements_from(obj_) / (sizeof(element_type) / sizeof(elementary_type)) : 0;
         }
-        ref_count_ = new std::size_t(0);
     }
 
-    template<typename T>
-    void shared_ptr<T>::reset() requires std::is_array_v<T> {
-        if (ref_count_ && *ref_count_ == 1) {
-            delete[] obj_;
+    // Pointer casts
+    // The result shares ownership with the argument and points to the same object viewed as another type.
+    // The overloads taking an rvalue move the reference over instead of incrementing the count
+
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> static_pointer_cast(const shared_ptr<Y, Policy> &ptr) noexcept {
+        return shared_ptr<T, Policy>(ptr, static_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get()));
+    }
+
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> static_pointer_cast(shared_ptr<Y, Policy> &&ptr) noexcept {
+        auto obj = static_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get());
+        return shared_ptr<T, Policy>(std::move(ptr), obj);
+    }
+
+    // Returns an empty shared_ptr if the object is not a T
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> dynamic_pointer_cast(const shared_ptr<Y, Policy> &ptr) noexcept {
+        if (auto obj = dynamic_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get())) {
+            return shared_ptr<T, Policy>(ptr, obj);
         }
-        obj_ = nullptr;
-        --*ref_count_;
-        if (*ref_count_ == 0) {
-            return;
+        return shared_ptr<T, Policy>();
+    }
+
+    // Leaves `ptr` untouched if the object is not a T
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> dynamic_pointer_cast(shared_ptr<Y, Policy> &&ptr) noexcept {
+        if (auto obj = dynamic_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get())) {
+            return shared_ptr<T, Policy>(std::move(ptr), obj);
         }
-        ref_count_ = new std::size_t(0);
+        return shared_ptr<T, Policy>();
     }
 
-    template<typename T>
-    shared_ptr<T>::element_type *shared_ptr<T>::get() const {
-        return obj_;
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> const_pointer_cast(const shared_ptr<Y, Policy> &ptr) noexcept {
+        return shared_ptr<T, Policy>(ptr, const_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get()));
+    }
+
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> const_pointer_cast(shared_ptr<Y, Policy> &&ptr) noexcept {
+        auto obj = const_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get());
+        return shared_ptr<T, Policy>(std::move(ptr), obj);
+    }
+
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> reinterpret_pointer_cast(const shared_ptr<Y, Policy> &ptr) noexcept {
+        return shared_ptr<T, Policy>(ptr, reinterpret_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get()));
+    }
+
+    template<typename T, typename Y, count_policy Policy>
+    shared_ptr<T, Policy> reinterpret_pointer_cast(shared_ptr<Y, Policy> &&ptr) noexcept {
+        auto obj = reinterpret_cast<typename shared_ptr<T, Policy>::element_type *>(ptr.get());
+        return shared_ptr<T, Policy>(std::move(ptr), obj);
+    }
+
+    // allocate_shared
+    // Same as make_shared, but the block holding the control block and the object (or the array) is allocated,
+    // and the object is constructed, through the given allocator
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc, typename... Args>
+    shared_ptr<T, Policy> allocate_shared(const Alloc &alloc, Args &&... args) requires (!std::is_array_v<T>) {
+        auto block = detail::make_inplace_block<T, Policy>(alloc, std::forward<Args>(args)...);
+        detail::enable_shared_from(block->get(), block);
+        return detail::shared_ptr_access::make<T, Policy>(block->get(), block);
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc>
+    shared_ptr<T, Policy> allocate_shared(const Alloc &alloc, std::size_t N)
+        requires std::is_array_v<T> && (!is_type_complete_v<T>) {
+        auto block = detail::make_array_block<std::remove_extent_t<T>, Policy>(alloc, N);
+        return detail::shared_ptr_access::make<T, Policy>(
+                reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc>
+    shared_ptr<T, Policy> allocate_shared(const Alloc &alloc) requires std::is_array_v<T> && is_type_complete_v<T> {
+        auto block = detail::make_array_block<std::remove_extent_t<T>, Policy>(alloc, std::extent_v<T>);
+        return detail::shared_ptr_access::make<T, Policy>(
+                reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc>
+        requires (std::is_array_v<T> && !is_type_complete_v<T>)
+    shared_ptr<T, Policy> allocate_shared(const Alloc &alloc, std::size_t N, const std::remove_extent_t<T> &u) {
+        auto block = detail::make_array_block<std::remove_extent_t<T>, Policy>(alloc, N, &u);
+        return detail::shared_ptr_access::make<T, Policy>(
+                reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc>
+        requires (std::is_array_v<T> && is_type_complete_v<T>)
+    shared_ptr<T, Policy> allocate_shared(const Alloc &alloc, const std::remove_extent_t<T> &u) {
+        auto block = detail::make_array_block<std::remove_extent_t<T>, Policy>(alloc, std::extent_v<T>, &u);
+        return detail::shared_ptr_access::make<T, Policy>(
+                reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
+    }
+
+    // allocate_shared_for_overwrite
+    // Same as allocate_shared, but the object or the elements are default-initialised: memory that the caller is
+    // going to overwrite anyway is not written twice. The object is constructed without the allocator's construct()
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc>
+    shared_ptr<T, Policy> allocate_shared_for_overwrite(const Alloc &alloc) requires (!std::is_array_v<T>) {
+        auto block = detail::make_inplace_block<T, Policy>(alloc, detail::for_overwrite);
+        detail::enable_shared_from(block->get(), block);
+        return detail::shared_ptr_access::make<T, Policy>(block->get(), block);
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc>
+    shared_ptr<T, Policy> allocate_shared_for_overwrite(const Alloc &alloc, std::size_t N)
+        requires std::is_array_v<T> && (!is_type_complete_v<T>) {
+        auto block = detail::make_array_block<std::remove_extent_t<T>, Policy>(alloc, N, detail::for_overwrite);
+        return detail::shared_ptr_access::make<T, Policy>(
+                reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
+    }
+
+    template<typename T, count_policy Policy = atomic_count, typename Alloc>
+    shared_ptr<T, Policy> allocate_shared_for_overwrite(const Alloc &alloc)
+        requires std::is_array_v<T> && is_type_complete_v<T> {
+        auto block = detail::make_array_block<std::remove_extent_t<T>, Policy>(alloc, std::extent_v<T>,
+                                                                              detail::for_overwrite);
+        return detail::shared_ptr_access::make<T, Policy>(
+                reinterpret_cast<std::remove_extent_t<T> *>(block->data()), block);
     }
 
     // make_shared
+    // Every overload allocates the object (or the array) and its control block with a single allocation
 
-    template<typename T, typename... Args>
-    shared_ptr<T> make_shared(Args &&... args) requires (!std::is_array_v<T>) {
-        return shared_ptr<T>(new T(std::forward<Args>(args)...));
+    template<typename T, count_policy Policy = atomic_count, typename... Args>
+    shared_ptr<T, Policy> make_shared(Args &&... args) requires (!std::is_array_v<T>) {
+        return allocate_shared<T, Policy>(detail::default_allocator<T>(), std::forward<Args>(args)...);
     }
 
-    template<typename T>
-    shared_ptr<T> make_shared(std::size_t N) requires std::is_array_v<T> {
-        return shared_ptr<T>(new std::remove_extent_t<T>[N]);
+    template<typename T, count_policy Policy = atomic_count>
+    shared_ptr<T, Policy> make_shared(std::size_t N) requires std::is_array_v<T> && (!is_type_complete_v<T>) {
+        return allocate_shared<T, Policy>(detail::default_allocator<T>(), N);
     }
 
-    template<typename T>
-    shared_ptr<T> make_shared() requires std::is_array_v<T> && is_type_complete_v<T> {
-        return shared_ptr<T>(new T);
+    template<typename T, count_policy Policy = atomic_count>
+    shared_ptr<T, Policy> make_shared() requires std::is_array_v<T> && is_type_complete_v<T> {
+        return allocate_shared<T, Policy>(detail::default_allocator<T>());
     }
 
-    template<typename T>
-        requires (std::is_array_v<T> && !is_type_complete_v<T> && std::is_array_v<std::remove_extent_t<T>>)
-    shared_ptr<T> make_shared(std::size_t N, const std::remove_extent_t<T> &u) {
-        auto array = new std::remove_extent_t<T>[N];
-        using elementary_type = std::remove_all_extents_t<T>;
-        for (std::size_t i = 0; i < N; ++i) {
-            auto array_1d = reinterpret_cast<elementary_type *>(array[i]);
-            for (std::size_t j = 0; j < sizeof(std::remove_extent_t<T>) / sizeof(elementary_type); ++j) {
-                auto u_1d = reinterpret_cast<const elementary_type *>(u);
-                array_1d[j] = u_1d[j];
+    template<typename T, count_policy Policy = atomic_count>
+        requires (std::is_array_v<T> && !is_type_complete_v<T>)
+    shared_ptr<T, Policy> make_shared(std::size_t N, const std::remove_extent_t<T> &u) {
+        return allocate_shared<T, Policy>(detail::default_allocator<T>(), N, u);
+    }
+
+    template<typename T, count_policy Policy = atomic_count>
+        requires (std::is_array_v<T> && is_type_complete_v<T>)
+    shared_ptr<T, Policy> make_shared(const std::remove_extent_t<T> &u) {
+        return allocate_shared<T, Policy>(detail::default_allocator<T>(), u);
+    }
+
+    // Where a shared_ptr is made. Passed to make_shared first, as in make_shared<T>(call_site(), args...), it lets
+    // instrumented builds (instrumentation.h) count the allocations of every call site; other builds ignore it
+    struct call_site {
+        std::source_location location;
+
+        explicit call_site(std::source_location location = std::source_location::current()) noexcept
+                : location(location) {}
+    };
+
+    template<typename T, count_policy Policy = atomic_count, typename... Args>
+    shared_ptr<T, Policy> make_shared(call_site site, Args &&... args) {
+        auto result = make_shared<T, Policy>(std::forward<Args>(args)...);
+#ifdef MP_CPP_HW1_INSTRUMENT
+        instrumentation::record_call_site(site.location,
+                                          detail::shared_ptr_access::control_block(result)->footprint());
+#else
+        (void) site;
+#endif
+        return result;
+    }
+
+    // make_shared_for_overwrite
+    // make_shared for buffers the caller fills itself: the object or the elements are default-initialised, so
+    // trivial types are not written at all
+
+    template<typename T, count_policy Policy = atomic_count>
+    shared_ptr<T, Policy> make_shared_for_overwrite() requires (!std::is_array_v<T>) || is_type_complete_v<T> {
+        return allocate_shared_for_overwrite<T, Policy>(detail::default_allocator<T>());
+    }
+
+    template<typename T, count_policy Policy = atomic_count>
+    shared_ptr<T, Policy> make_shared_for_overwrite(std::size_t N)
+        requires std::is_array_v<T> && (!is_type_complete_v<T>) {
+        return allocate_shared_for_overwrite<T, Policy>(detail::default_allocator<T>(), N);
+    }
+
+    // allocate_shared_batch
+    // `count` objects constructed from the same arguments in a single allocation under a single control block, for
+    // bulk loads of objects that live and die together. Each of them gets a handle of its own, but every handle owns
+    // the whole batch: all the objects are destroyed and the memory is freed once no handle to any of them is left.
+    // Throws std::length_error if the use count of the policy cannot hold `count` owners
+    template<typename T, count_policy Policy = atomic_count, typename Alloc, typename... Args>
+    std::vector<shared_ptr<T, Policy>> allocate_shared_batch(const Alloc &alloc, std::size_t count, Args &&... args)
+        requires (!std::is_array_v<T>) {
+        std::vector<shared_ptr<T, Policy>> batch;
+        if (count == 0) {
+            return batch;
+        }
+        if constexpr (requires { Policy::counts::max_use_count; }) {
+            if (count > Policy::counts::max_use_count) {
+                throw std::length_error("make_shared_batch: more objects than the use count can hold");
             }
         }
-        return shared_ptr<T>(array);
+        // Reserved first: once the objects exist, nothing may throw
+        batch.reserve(count);
+        auto block = detail::make_batch_block<T, Policy>(alloc, count, args...);
+        for (std::size_t i = 0; i < count; ++i) {
+            T *obj = block->data() + i;
+            detail::enable_shared_from(obj, block);
+            batch.push_back(detail::shared_ptr_access::make<T, Policy>(obj, block));
+        }
+        return batch;
     }
 
-    template<typename T>
-        requires (std::is_array_v<T> && !is_type_complete_v<T> && !std::is_array_v<std::remove_extent_t<T>>)
-    shared_ptr<T> make_shared(std::size_t N, const std::remove_extent_t<T> &u) {
-        auto array = new std::remove_extent_t<T>[N];
-        for (std::size_t i = 0; i < N; ++i) {
-            array[i] = u;
+    // Same as allocate_shared_batch, with the default allocator
+    template<typename T, count_policy Policy = atomic_count, typename... Args>
+    std::vector<shared_ptr<T, Policy>> make_shared_batch(std::size_t count, Args &&... args)
+        requires (!std::is_array_v<T>) {
+        return allocate_shared_batch<T, Policy>(detail::default_allocator<T>(), count, std::forward<Args>(args)...);
+    }
+
+    // A non-owning reference to an object managed by shared_ptr. It does not keep the object alive but can
+    // tell whether it still exists and temporarily become an owner through lock()
+    template<typename T, count_policy Policy>
+    class weak_ptr {
+        using element_type = std::remove_reference_t<std::remove_extent_t<T>>;
+    public:
+        // Constructs an empty weak_ptr
+        constexpr weak_ptr() noexcept;
+
+        // Construct a weak_ptr observing the object managed by the given shared_ptr
+        weak_ptr(const shared_ptr<T, Policy> &owner) noexcept;
+
+        // Copy constructor
+        weak_ptr(const weak_ptr &other) noexcept;
+
+        // Move constructor
+        weak_ptr(weak_ptr &&other) noexcept;
+
+        // Destructor
+        constexpr ~weak_ptr();
+
+        // Copy assignment operator
+        weak_ptr &operator=(const weak_ptr &other) noexcept;
+
+        // Move assignment operator
+        weak_ptr &operator=(weak_ptr &&other) noexcept;
+
+        // Start observing the object managed by the given shared_ptr
+        weak_ptr &operator=(const shared_ptr<T, Policy> &owner) noexcept;
+
+        // Get the number of owners of the observed object
+        [[nodiscard]] std::size_t use_count() const noexcept;
+
+        // Check whether the observed object was already destroyed
+        [[nodiscard]] bool expired() const noexcept;
+
+        // Get an owning pointer to the observed object, or an empty one if it was already destroyed
+        shared_ptr<T, Policy> lock() const noexcept;
+
+        // Stop observing the object
+        constexpr void reset() noexcept;
+
+    private:
+        template<typename, count_policy>
+        friend class enable_shared_from_this;
+
+        template<typename P, typename Y>
+        friend void detail::enable_shared_from(Y *obj, detail::control_block_base<P> *ctrl) noexcept;
+
+        element_type *obj_;
+        detail::control_block_base<Policy> *ctrl_;
+
+        // Take a weak reference to the block of another pointer
+        void acquire(element_type *obj, detail::control_block_base<Policy> *ctrl) noexcept;
+    };
+
+    template<typename T, count_policy Policy>
+    constexpr weak_ptr<T, Policy>::weak_ptr() noexcept : obj_(nullptr), ctrl_(nullptr) {}
+
+    template<typename T, count_policy Policy>
+    weak_ptr<T, Policy>::weak_ptr(const shared_ptr<T, Policy> &owner) noexcept : obj_(nullptr), ctrl_(nullptr) {
+        acquire(owner.obj_, owner.ctrl_);
+    }
+
+    template<typename T, count_policy Policy>
+    weak_ptr<T, Policy>::weak_ptr(const weak_ptr &other) noexcept : obj_(nullptr), ctrl_(nullptr) {
+        acquire(other.obj_, other.ctrl_);
+    }
+
+    template<typename T, count_policy Policy>
+    weak_ptr<T, Policy>::weak_ptr(weak_ptr &&other) noexcept : obj_(other.obj_), ctrl_(other.ctrl_) {
+        other.obj_ = nullptr;
+        other.ctrl_ = nullptr;
+    }
+
+    template<typename T, count_policy Policy>
+    constexpr weak_ptr<T, Policy>::~weak_ptr() {
+        reset();
+    }
+
+    template<typename T, count_policy Policy>
+    weak_ptr<T, Policy> &weak_ptr<T, Policy>::operator=(const weak_ptr &other) noexcept {
+        if (this != &other) {
+            acquire(other.obj_, other.ctrl_);
         }
-        return shared_ptr<T>(array);
+        return *this;
     }
 
-    template<typename T>
-        requires std::is_array_v<T> && is_type_complete_v<T> && std::is_array_v<std::remove_extent_t<T>>
-    shared_ptr<T> make_shared(const std::remove_extent_t<T> &u) {
-        auto array = shared_ptr<T>(new T);
-        using elementary_type = std::remove_all_extents_t<T>;
-        for (std::size_t i = 0; i < std::extent_v<T>; ++i) {
-            auto array_1d = reinterpret_cast<elementary_type *>(array[i]);
-            for (std::size_t j = 0; j < sizeof(std::remove_extent_t<T>) / sizeof(elementary_type); ++j) {
-                auto u_1d = reinterpret_cast<const elementary_type *>(u);
-                array_1d[j] = u_1d[j];
-            }
+    template<typename T, count_policy Policy>
+    weak_ptr<T, Policy> &weak_ptr<T, Policy>::operator=(weak_ptr &&other) noexcept {
+        if (this != &other) {
+            auto obj = other.obj_;
+            auto ctrl = other.ctrl_;
+            other.obj_ = nullptr;
+            other.ctrl_ = nullptr;
+            reset();
+            obj_ = obj;
+            ctrl_ = ctrl;
+        }
+        return *this;
+    }
+
+    template<typename T, count_policy Policy>
+    weak_ptr<T, Policy> &weak_ptr<T, Policy>::operator=(const shared_ptr<T, Policy> &owner) noexcept {
+        acquire(owner.obj_, owner.ctrl_);
+        return *this;
+    }
+
+    template<typename T, count_policy Policy>
+    std::size_t weak_ptr<T, Policy>::use_count() const noexcept {
+        return ctrl_ ? ctrl_->use_count() : 0;
+    }
+
+    template<typename T, count_policy Policy>
+    bool weak_ptr<T, Policy>::expired() const noexcept {
+        return use_count() == 0;
+    }
+
+    template<typename T, count_policy Policy>
+    shared_ptr<T, Policy> weak_ptr<T, Policy>::lock() const noexcept {
+        if (ctrl_ && ctrl_->try_add_ref()) {
+            return shared_ptr<T, Policy>(obj_, ctrl_);
         }
-        return array;
+        return shared_ptr<T, Policy>();
+    }
+
+    template<typename T, count_policy Policy>
+    constexpr void weak_ptr<T, Policy>::reset() noexcept {
+        if (ctrl_) {
+            ctrl_->release_weak();
+        }
+        obj_ = nullptr;
+        ctrl_ = nullptr;
+    }
+
+    template<typename T, count_policy Policy>
+    void weak_ptr<T, Policy>::acquire(element_type *obj, detail::control_block_base<Policy> *ctrl) noexcept {
+        // Take the new reference first: the old block may be the same one
+        if (ctrl) {
+            ctrl->add_weak_ref();
+        }
+        reset();
+        obj_ = obj;
+        ctrl_ = ctrl;
     }
 
+    // Objects of type T can be moved to another address by copying their bytes, after which the source is simply
+    // forgotten: its destructor is not run. True for trivially copyable types and for the pointers of this library,
+    // which refer to their control block but are never referred to themselves. Specialize it for other such types
     template<typename T>
-        requires (std::is_array_v<T> && is_type_complete_v<T> && !std::is_array_v<std::remove_extent_t<T>>)
-    shared_ptr<T> make_shared(const std::remove_extent_t<T> &u) {
-        auto array = shared_ptr<T>(new T);
-        for (std::size_t i = 0; i < std::extent_v<T>; ++i) {
-            array[i] = u;
+    struct is_trivially_relocatable : std::bool_constant<std::is_trivially_copyable_v<T>> {};
+
+    template<typename T, count_policy Policy>
+    struct is_trivially_relocatable<shared_ptr<T, Policy>> : std::true_type {};
+
+    template<typename T, count_policy Policy>
+    struct is_trivially_relocatable<weak_ptr<T, Policy>> : std::true_type {};
+
+    template<typename T>
+    constexpr bool is_trivially_relocatable_v = is_trivially_relocatable<T>::value;
+
+    // Base class for objects that need shared_ptrs to themselves, e.g. to hand them to the callbacks and timers they
+    // register. The shared_ptr constructors taking a pointer, make_shared and allocate_shared give the object a
+    // weak reference to its control block, so no extra allocation is made, and shared_from_this() only increments
+    // the count in it, unless the count has already dropped to zero
+    template<typename T, count_policy Policy>
+    class enable_shared_from_this {
+    public:
+        // The class the object hands out pointers to
+        using shared_from_this_type = T;
+
+        // Share ownership of the object with the shared_ptrs that own it. Throws std::bad_weak_ptr if no shared_ptr
+        // has ever owned it or the last owner is already gone, e.g. when called from the destructor
+        shared_ptr<T, Policy> shared_from_this();
+
+        shared_ptr<const T, Policy> shared_from_this() const;
+
+        // A weak_ptr to the object, empty if no shared_ptr has ever owned it
+        weak_ptr<T, Policy> weak_from_this() noexcept {
+            return weak_this_;
+        }
+
+        weak_ptr<const T, Policy> weak_from_this() const noexcept;
+
+    protected:
+        constexpr enable_shared_from_this() noexcept = default;
+
+        // A copy is a new object: the owners of the original do not own it
+        enable_shared_from_this(const enable_shared_from_this &) noexcept {}
+
+        // Assignment changes the value of the object, not its owners
+        enable_shared_from_this &operator=(const enable_shared_from_this &) noexcept {
+            return *this;
+        }
+
+        ~enable_shared_from_this() = default;
+
+    private:
+        template<typename P, typename Y>
+        friend void detail::enable_shared_from(Y *obj, detail::control_block_base<P> *ctrl) noexcept;
+
+        mutable weak_ptr<T, Policy> weak_this_;
+    };
+
+    template<typename T, count_policy Policy>
+    shared_ptr<T, Policy> enable_shared_from_this<T, Policy>::shared_from_this() {
+        // The increment fails at zero: a destructor running because the last owner went must not revive the object
+        if (!weak_this_.ctrl_ || !weak_this_.ctrl_->try_add_ref()) {
+            throw std::bad_weak_ptr();
         }
-        return array;
+        return detail::shared_ptr_access::make<T, Policy>(weak_this_.obj_, weak_this_.ctrl_);
     }
+
+    template<typename T, count_policy Policy>
+    shared_ptr<const T, Policy> enable_shared_from_this<T, Policy>::shared_from_this() const {
+        if (!weak_this_.ctrl_ || !weak_this_.ctrl_->try_add_ref()) {
+            throw std::bad_weak_ptr();
+        }
+        return detail::shared_ptr_access::make<const T, Policy>(weak_this_.obj_, weak_this_.ctrl_);
+    }
+
+    template<typename T, count_policy Policy>
+    weak_ptr<const T, Policy> enable_shared_from_this<T, Policy>::weak_from_this() const noexcept {
+        weak_ptr<const T, Policy> weak;
+        weak.acquire(weak_this_.obj_, weak_this_.ctrl_);
+        return weak;
+    }
+
+    namespace detail {
+        template<typename Policy, typename Y>
+        void enable_shared_from(Y *obj, control_block_base<Policy> *ctrl) noexcept {
+            using object_type = std::remove_cv_t<Y>;
+            if constexpr (shares_from_this<object_type, Policy>) {
+                using base = enable_shared_from_this<typename object_type::shared_from_this_type, Policy>;
+                base *self = const_cast<object_type *>(obj);
+                // An object that already has owners keeps them, like with std::enable_shared_from_this
+                if (self && self->weak_this_.expired()) {
+                    self->weak_this_.acquire(static_cast<typename base::shared_from_this_type *>(self), ctrl);
+                }
+            } else {
+                (void) obj;
+                (void) ctrl;
+            }
+        }
+    }  // namespace detail
 }  // namespace smart_pointer
 
 #endif  // MP_CPP_HW1_SHARED_PTR
@@ -0,0 +1,139 @@
+#ifndef MP_CPP_HW1_SHARED_VALUE
+#define MP_CPP_HW1_SHARED_VALUE
+
+#include <cstddef>  // std::size_t, std::nullptr_t
+#include <optional>  // std::optional
+#include <type_traits>  // std::bool_constant, std::conditional_t, std::conjunction_v, std::true_type
+#include <utility>  // std::forward, std::in_place, std::swap
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    template<typename T, std::size_t InlineSize, count_policy Policy>
+    class shared_value;
+
+    namespace detail {
+        // Whether a value and the flag telling an empty handle from a full one fit in `Size` bytes
+        template<typename T, std::size_t Size>
+        struct fits_inline : std::bool_constant<sizeof(std::optional<T>) <= Size> {};
+    }  // namespace detail
+
+    template<typename T, std::size_t InlineSize = 2 * sizeof(void *), count_policy Policy = atomic_count,
+             typename... Args>
+    shared_value<T, InlineSize, Policy> make_shared_value(Args &&... args);
+
+    // A shared, immutable value. Values of trivially copyable types are kept in the handle itself and copied with it
+    // if the handle holding one, with the flag of an empty handle, is no bigger than InlineSize bytes. The default
+    // keeps it at the size of a shared_ptr, so a value of up to 12 bytes fits, or of 8 with 8-byte alignment. There
+    // is no control block to allocate and no count to update, and reading the value does not leave the handle. Other
+    // values are kept in a block shared by all the copies, like shared_ptr<const T, Policy> does.
+    //
+    // get(), operator* and operator-> give the value in both cases. Since an inline value belongs to its handle,
+    // copies of it have different addresses, and the address changes when the handle is moved
+    template<typename T, std::size_t InlineSize = 2 * sizeof(void *), count_policy Policy = atomic_count>
+    class shared_value {
+    public:
+        using element_type = const T;
+
+        // Whether the values are kept in the handle
+        static constexpr bool stored_inline =
+                std::conjunction_v<std::is_trivially_copyable<T>, detail::fits_inline<T, InlineSize>>;
+
+        // Constructs an empty shared_value
+        constexpr shared_value() noexcept = default;
+
+        // Constructs another empty shared_value
+        constexpr shared_value(std::nullptr_t) noexcept {}
+
+        // Share a value already owned by shared_ptrs. An inline value is copied out of the object
+        explicit shared_value(const shared_ptr<const T, Policy> &ptr);
+
+        // Dereference operator
+        const T &operator*() const noexcept {
+            return *get();
+        }
+
+        // Member access operator
+        const T *operator->() const noexcept {
+            return get();
+        }
+
+        // Boolean conversion operator
+        explicit operator bool() const noexcept {
+            return static_cast<bool>(storage_);
+        }
+
+        // Get a pointer to the value, or nullptr if there is none
+        const T *get() const noexcept;
+
+        // Get the number of handles sharing the value: 1 for an inline value, which every handle has a copy of
+        [[nodiscard]] std::size_t use_count() const noexcept;
+
+        // Drop the value
+        void reset() noexcept {
+            storage_.reset();
+        }
+
+        void swap(shared_value &other) noexcept {
+            std::swap(storage_, other.storage_);
+        }
+
+    private:
+        template<typename U, std::size_t Size, count_policy P, typename... Args>
+        friend shared_value<U, Size, P> make_shared_value(Args &&... args);
+
+        std::conditional_t<stored_inline, std::optional<T>, shared_ptr<const T, Policy>> storage_;
+    };
+
+    template<typename T, std::size_t InlineSize, count_policy Policy>
+    shared_value<T, InlineSize, Policy>::shared_value(const shared_ptr<const T, Policy> &ptr) {
+        if constexpr (stored_inline) {
+            if (ptr) {
+                storage_.emplace(*ptr);
+            }
+        } else {
+            storage_ = ptr;
+        }
+    }
+
+    template<typename T, std::size_t InlineSize, count_policy Policy>
+    const T *shared_value<T, InlineSize, Policy>::get() const noexcept {
+        if constexpr (stored_inline) {
+            return storage_ ? &*storage_ : nullptr;
+        } else {
+            return storage_.get();
+        }
+    }
+
+    template<typename T, std::size_t InlineSize, count_policy Policy>
+    std::size_t shared_value<T, InlineSize, Policy>::use_count() const noexcept {
+        if constexpr (stored_inline) {
+            return storage_ ? 1 : 0;
+        } else {
+            return storage_.use_count();
+        }
+    }
+
+    // Create a value and the first handle to it. Only values that are not kept inline are allocated
+    template<typename T, std::size_t InlineSize, count_policy Policy, typename... Args>
+    shared_value<T, InlineSize, Policy> make_shared_value(Args &&... args) {
+        shared_value<T, InlineSize, Policy> value;
+        if constexpr (shared_value<T, InlineSize, Policy>::stored_inline) {
+            value.storage_.emplace(std::forward<Args>(args)...);
+        } else {
+            value.storage_ = make_shared<T, Policy>(std::forward<Args>(args)...);
+        }
+        return value;
+    }
+
+    // Either a shared_ptr or a trivially copyable value
+    template<typename T, std::size_t InlineSize, count_policy Policy>
+    struct is_trivially_relocatable<shared_value<T, InlineSize, Policy>> : std::true_type {};
+
+    template<typename T, std::size_t InlineSize, count_policy Policy>
+    void swap(shared_value<T, InlineSize, Policy> &lhs, shared_value<T, InlineSize, Policy> &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_SHARED_VALUE
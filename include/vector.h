@@ -0,0 +1,428 @@
+#ifndef MP_CPP_HW1_VECTOR
+#define MP_CPP_HW1_VECTOR
+
+#include <algorithm>  // std::max, std::move, std::move_backward
+#include <cstddef>  // std::size_t, std::max_align_t
+#include <cstdlib>  // std::realloc, std::free
+#include <cstring>  // std::memcpy, std::memmove
+#include <initializer_list>  // std::initializer_list
+#include <memory>  // std::allocator, std::allocator_traits, std::construct_at, std::destroy_at
+#include <new>  // std::bad_alloc, std::bad_array_new_length
+#include <type_traits>  // std::is_nothrow_move_constructible_v, std::is_same_v
+#include <utility>  // std::forward, std::move, std::swap, std::exchange
+
+#include "shared_ptr.h"
+
+namespace smart_pointer {
+    // T can be relocated without a chance of failure: by copying its bytes, or by a move constructor that does not
+    // throw followed by the destructor
+    template<typename T>
+    concept nothrow_relocatable = is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>;
+
+    // Move the objects of [first, last) to the uninitialised memory at `dest`, leaving [first, last) uninitialised.
+    // Trivially relocatable objects are moved with a single memmove, so the ranges may overlap; other objects are
+    // moved one by one from the first, so `dest` must not be inside (first, last). Returns the end of the
+    // relocated range
+    template<nothrow_relocatable T>
+    T *uninitialized_relocate(T *first, T *last, T *dest) noexcept {
+        if constexpr (is_trivially_relocatable_v<T>) {
+            if (first != last) {
+                std::memmove(static_cast<void *>(dest), static_cast<const void *>(first),
+                             static_cast<std::size_t>(last - first) * sizeof(T));
+            }
+            return dest + (last - first);
+        } else {
+            for (; first != last; ++first, ++dest) {
+                std::construct_at(dest, std::move(*first));
+                std::destroy_at(first);
+            }
+            return dest;
+        }
+    }
+
+    // A growable array like std::vector, for elements that relocate without failing. Trivially relocatable ones,
+    // like shared_ptr, are moved by memcpy when the array grows and by memmove when elements are inserted or erased
+    // in the middle, instead of a move constructor and a destructor per element. Iterators are plain pointers and
+    // are invalidated like those of std::vector
+    template<nothrow_relocatable T, typename Alloc = std::allocator<T>>
+    class vector {
+        using traits = std::allocator_traits<Alloc>;
+
+        // Move assignment can take over the array of the other vector
+        static constexpr bool steals_on_move = traits::propagate_on_container_move_assignment::value ||
+                                               traits::is_always_equal::value;
+
+        // The array is managed with malloc and realloc instead of the allocator: realloc can extend it in place or,
+        // for big arrays, move its pages to a bigger mapping, so growing does not even copy the elements. Only
+        // std::allocator may be bypassed like that
+        static constexpr bool reallocates = is_trivially_relocatable_v<T> && std::is_same_v<Alloc, std::allocator<T>> &&
+                                            alignof(T) <= alignof(std::max_align_t);
+
+    public:
+        using value_type = T;
+        using allocator_type = Alloc;
+        using size_type = std::size_t;
+        using iterator = T *;
+        using const_iterator = const T *;
+
+        // Constructs an empty vector, which does not allocate
+        vector() noexcept(noexcept(Alloc())) = default;
+
+        explicit vector(const Alloc &alloc) noexcept : alloc_(alloc) {}
+
+        vector(std::initializer_list<T> values, const Alloc &alloc = Alloc());
+
+        vector(const vector &other);
+
+        vector(vector &&other) noexcept;
+
+        ~vector();
+
+        vector &operator=(const vector &other);
+
+        vector &operator=(vector &&other) noexcept(steals_on_move);
+
+        T &operator[](std::size_t idx) noexcept {
+            return data_[idx];
+        }
+
+        const T &operator[](std::size_t idx) const noexcept {
+            return data_[idx];
+        }
+
+        T &front() noexcept {
+            return data_[0];
+        }
+
+        T &back() noexcept {
+            return data_[size_ - 1];
+        }
+
+        T *data() noexcept {
+            return data_;
+        }
+
+        const T *data() const noexcept {
+            return data_;
+        }
+
+        T *begin() noexcept {
+            return data_;
+        }
+
+        const T *begin() const noexcept {
+            return data_;
+        }
+
+        T *end() noexcept {
+            return data_ + size_;
+        }
+
+        const T *end() const noexcept {
+            return data_ + size_;
+        }
+
+        [[nodiscard]] bool empty() const noexcept {
+            return size_ == 0;
+        }
+
+        [[nodiscard]] std::size_t size() const noexcept {
+            return size_;
+        }
+
+        [[nodiscard]] std::size_t capacity() const noexcept {
+            return capacity_;
+        }
+
+        // Make room for `count` elements without reallocating
+        void reserve(std::size_t count);
+
+        // Destroy the elements past `count`, or append value-initialised elements up to it
+        void resize(std::size_t count);
+
+        void push_back(const T &value) {
+            emplace_back(value);
+        }
+
+        void push_back(T &&value) {
+            emplace_back(std::move(value));
+        }
+
+        template<typename... Args>
+        T &emplace_back(Args &&... args) {
+            return *emplace(end(), std::forward<Args>(args)...);
+        }
+
+        void pop_back() noexcept {
+            traits::destroy(alloc_, data_ + --size_);
+        }
+
+        T *insert(const T *pos, const T &value) {
+            return emplace(pos, value);
+        }
+
+        T *insert(const T *pos, T &&value) {
+            return emplace(pos, std::move(value));
+        }
+
+        // Construct an element before `pos`. The arguments may refer to elements of the vector
+        template<typename... Args>
+        T *emplace(const T *pos, Args &&... args);
+
+        T *erase(const T *pos) noexcept {
+            return erase(pos, pos + 1);
+        }
+
+        // Destroy the elements of [first, last) and close the gap. Returns the element that followed them
+        T *erase(const T *first, const T *last) noexcept;
+
+        void clear() noexcept {
+            destroy(data_, data_ + size_);
+            size_ = 0;
+        }
+
+        void swap(vector &other) noexcept;
+
+    private:
+        T *data_ = nullptr;
+        std::size_t size_ = 0;
+        std::size_t capacity_ = 0;
+        [[no_unique_address]] Alloc alloc_;
+
+        // Capacity to grow to so that at least `count` elements fit
+        [[nodiscard]] std::size_t grown_capacity(std::size_t count) const;
+
+        // Move the elements to an array of `capacity` elements
+        void reallocate(std::size_t capacity);
+
+        void deallocate() noexcept;
+
+        void destroy(T *first, T *last) noexcept {
+            for (; first != last; ++first) {
+                traits::destroy(alloc_, first);
+            }
+        }
+
+        // Copy [first, last) into the vector, which must be empty
+        void copy_from(const T *first, const T *last);
+
+        // Destroy the elements and free the array
+        void release() noexcept;
+    };
+
+    template<nothrow_relocatable T, typename Alloc>
+    vector<T, Alloc>::vector(std::initializer_list<T> values, const Alloc &alloc) : alloc_(alloc) {
+        copy_from(values.begin(), values.end());
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    vector<T, Alloc>::vector(const vector &other)
+            : alloc_(traits::select_on_container_copy_construction(other.alloc_)) {
+        copy_from(other.begin(), other.end());
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    vector<T, Alloc>::vector(vector &&other) noexcept
+            : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+              capacity_(std::exchange(other.capacity_, 0)), alloc_(std::move(other.alloc_)) {}
+
+    template<nothrow_relocatable T, typename Alloc>
+    vector<T, Alloc>::~vector() {
+        release();
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    vector<T, Alloc> &vector<T, Alloc>::operator=(const vector &other) {
+        if (this != &other) {
+            vector copy(other);
+            swap(copy);
+        }
+        return *this;
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    vector<T, Alloc> &vector<T, Alloc>::operator=(vector &&other) noexcept(steals_on_move) {
+        if (this == &other) {
+            return *this;
+        }
+        release();
+        if constexpr (!steals_on_move) {
+            if (alloc_ != other.alloc_) {
+                // Our allocator cannot free the array of the other one: move the elements over
+                reserve(other.size_);
+                uninitialized_relocate(other.data_, other.data_ + other.size_, data_);
+                size_ = std::exchange(other.size_, 0);
+                return *this;
+            }
+        }
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        capacity_ = std::exchange(other.capacity_, 0);
+        if constexpr (traits::propagate_on_container_move_assignment::value) {
+            alloc_ = std::move(other.alloc_);
+        }
+        return *this;
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void vector<T, Alloc>::reserve(std::size_t count) {
+        if (count > capacity_) {
+            reallocate(count);
+        }
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void vector<T, Alloc>::resize(std::size_t count) {
+        if (count <= size_) {
+            erase(data_ + count, data_ + size_);
+            return;
+        }
+        reserve(count);
+        for (; size_ < count; ++size_) {
+            traits::construct(alloc_, data_ + size_);
+        }
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    template<typename... Args>
+    T *vector<T, Alloc>::emplace(const T *pos, Args &&... args) {
+        auto index = static_cast<std::size_t>(pos - data_);
+        if constexpr (is_trivially_relocatable_v<T>) {
+            // Build the element aside, as the arguments may refer to an element that is about to move. Then make
+            // room, shift the tail up by one place and drop the bytes of the element into the gap
+            alignas(T) unsigned char slot[sizeof(T)];
+            T *value = reinterpret_cast<T *>(slot);
+            traits::construct(alloc_, value, std::forward<Args>(args)...);
+            if (size_ == capacity_) {
+                try {
+                    reallocate(grown_capacity(size_ + 1));
+                } catch (...) {
+                    traits::destroy(alloc_, value);
+                    throw;
+                }
+            }
+            uninitialized_relocate(data_ + index, data_ + size_, data_ + index + 1);
+            std::memcpy(static_cast<void *>(data_ + index), slot, sizeof(T));
+        } else if (size_ == capacity_) {
+            // Build the element in the new array first: the arguments may refer to the old one
+            std::size_t capacity = grown_capacity(size_ + 1);
+            T *fresh = traits::allocate(alloc_, capacity);
+            try {
+                traits::construct(alloc_, fresh + index, std::forward<Args>(args)...);
+            } catch (...) {
+                traits::deallocate(alloc_, fresh, capacity);
+                throw;
+            }
+            uninitialized_relocate(data_, data_ + index, fresh);
+            uninitialized_relocate(data_ + index, data_ + size_, fresh + index + 1);
+            deallocate();
+            data_ = fresh;
+            capacity_ = capacity;
+        } else if (index == size_) {
+            traits::construct(alloc_, data_ + index, std::forward<Args>(args)...);
+        } else {
+            T value(std::forward<Args>(args)...);
+            traits::construct(alloc_, data_ + size_, std::move(data_[size_ - 1]));
+            std::move_backward(data_ + index, data_ + size_ - 1, data_ + size_);
+            data_[index] = std::move(value);
+        }
+        ++size_;
+        return data_ + index;
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    T *vector<T, Alloc>::erase(const T *first, const T *last) noexcept {
+        T *begin = data_ + (first - data_);
+        T *end = data_ + (last - data_);
+        if (begin == end) {
+            return begin;
+        }
+        if constexpr (is_trivially_relocatable_v<T>) {
+            destroy(begin, end);
+            uninitialized_relocate(end, data_ + size_, begin);
+        } else {
+            T *tail = std::move(end, data_ + size_, begin);
+            destroy(tail, data_ + size_);
+        }
+        size_ -= static_cast<std::size_t>(end - begin);
+        return begin;
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void vector<T, Alloc>::swap(vector &other) noexcept {
+        std::swap(data_, other.data_);
+        std::swap(size_, other.size_);
+        std::swap(capacity_, other.capacity_);
+        if constexpr (traits::propagate_on_container_swap::value) {
+            std::swap(alloc_, other.alloc_);
+        }
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    std::size_t vector<T, Alloc>::grown_capacity(std::size_t count) const {
+        std::size_t limit = traits::max_size(alloc_);
+        if (count > limit) {
+            throw std::bad_array_new_length();
+        }
+        return capacity_ > limit / 2 ? limit : std::max(count, capacity_ * 2);
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void vector<T, Alloc>::reallocate(std::size_t capacity) {
+        if constexpr (reallocates) {
+            if (capacity > traits::max_size(alloc_)) {
+                throw std::bad_array_new_length();
+            }
+            // realloc moves the bytes of the elements if it cannot grow the block in place, which relocates a
+            // trivially relocatable T: the old bytes are forgotten and no destructor runs on them
+            void *fresh = std::realloc(static_cast<void *>(data_), capacity * sizeof(T));
+            if (!fresh) {
+                throw std::bad_alloc();
+            }
+            data_ = static_cast<T *>(fresh);
+        } else {
+            T *fresh = traits::allocate(alloc_, capacity);
+            uninitialized_relocate(data_, data_ + size_, fresh);
+            deallocate();
+            data_ = fresh;
+        }
+        capacity_ = capacity;
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void vector<T, Alloc>::deallocate() noexcept {
+        if constexpr (reallocates) {
+            std::free(data_);
+        } else if (data_) {
+            traits::deallocate(alloc_, data_, capacity_);
+        }
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void vector<T, Alloc>::copy_from(const T *first, const T *last) {
+        reserve(static_cast<std::size_t>(last - first));
+        try {
+            for (; first != last; ++first, ++size_) {
+                traits::construct(alloc_, data_ + size_, *first);
+            }
+        } catch (...) {
+            release();
+            throw;
+        }
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void vector<T, Alloc>::release() noexcept {
+        clear();
+        deallocate();
+        data_ = nullptr;
+        capacity_ = 0;
+    }
+
+    template<nothrow_relocatable T, typename Alloc>
+    void swap(vector<T, Alloc> &lhs, vector<T, Alloc> &rhs) noexcept {
+        lhs.swap(rhs);
+    }
+}  // namespace smart_pointer
+
+#endif  // MP_CPP_HW1_VECTOR
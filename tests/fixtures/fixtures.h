@@ -0,0 +1,57 @@
+#ifndef MP_CPP_HW1_FIXTURES
+#define MP_CPP_HW1_FIXTURES
+
+#include <memory>  // std::make_shared, std::shared_ptr
+#include <type_traits>  // std::is_same_v
+#include <utility>  // std::forward
+
+#include "shared_ptr.h"
+
+// The managed types the unit tests and the benchmarks share: the class hierarchy of exe/main.cpp, cut down
+namespace fixtures {
+    struct Animal {
+        // The animals alive on the calling thread, for tests checking that every object is destroyed. Counted per
+        // thread, so that benchmarks making animals on several threads share no counter
+        static inline thread_local int live = 0;
+
+        Animal() noexcept {
+            ++live;
+        }
+
+        Animal(const Animal &) noexcept {
+            ++live;
+        }
+
+        virtual ~Animal() {
+            --live;
+        }
+
+        virtual int legs() const {
+            return 0;
+        }
+
+        // A field to read through a handle without a virtual call
+        int age = 1;
+    };
+
+    struct Dog : Animal {
+        int legs() const override {
+            return 4;
+        }
+
+        int tail = 1;
+    };
+
+    // Make an object with the make_shared of the library the pointer type comes from, for code run with both
+    template<typename Pointer, typename... Args>
+    Pointer make(Args &&... args) {
+        using T = typename Pointer::element_type;
+        if constexpr (std::is_same_v<Pointer, std::shared_ptr<T>>) {
+            return std::make_shared<T>(std::forward<Args>(args)...);
+        } else {
+            return smart_pointer::make_shared<T>(std::forward<Args>(args)...);
+        }
+    }
+}  // namespace fixtures
+
+#endif  // MP_CPP_HW1_FIXTURES
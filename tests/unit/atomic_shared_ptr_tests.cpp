@@ -0,0 +1,105 @@
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include "atomic_shared_ptr.h"
+#include "gtest/gtest.h"
+
+namespace {
+    // Counts live instances to check that every published value is eventually destroyed
+    struct Snapshot {
+        static inline std::atomic<int> live = 0;
+
+        int version;
+
+        explicit Snapshot(int version) : version(version) {
+            ++live;
+        }
+
+        ~Snapshot() {
+            --live;
+        }
+    };
+}  // namespace
+
+TEST(testAtomicSharedPtr, testLoadStore) {
+    smart_pointer::atomic_shared_ptr<int> atomic;
+    EXPECT_TRUE(atomic.is_lock_free());
+    EXPECT_EQ(atomic.load().get(), nullptr);
+    auto sp = smart_pointer::make_shared<int>(1);
+    atomic.store(sp);
+    EXPECT_EQ(sp.use_count(), 2);
+    smart_pointer::shared_ptr<int> loaded = atomic;
+    EXPECT_EQ(loaded.get(), sp.get());
+    EXPECT_EQ(sp.use_count(), 3);
+    atomic = smart_pointer::shared_ptr<int>();
+    EXPECT_EQ(atomic.load().get(), nullptr);
+    EXPECT_EQ(sp.use_count(), 2);
+}
+
+TEST(testAtomicSharedPtr, testExchange) {
+    auto first = smart_pointer::make_shared<int>(1);
+    smart_pointer::atomic_shared_ptr<int> atomic(first);
+    auto previous = atomic.exchange(smart_pointer::make_shared<int>(2));
+    EXPECT_EQ(previous.get(), first.get());
+    EXPECT_EQ(first.use_count(), 2);
+    EXPECT_EQ(*atomic.load(), 2);
+}
+
+TEST(testAtomicSharedPtr, testCompareExchange) {
+    auto first = smart_pointer::make_shared<int>(1);
+    smart_pointer::atomic_shared_ptr<int> atomic(first);
+    auto expected = smart_pointer::make_shared<int>(1);
+    EXPECT_FALSE(atomic.compare_exchange_strong(expected, smart_pointer::make_shared<int>(2)));
+    EXPECT_EQ(expected.get(), first.get());
+    EXPECT_TRUE(atomic.compare_exchange_strong(expected, smart_pointer::make_shared<int>(3)));
+    EXPECT_EQ(*atomic.load(), 3);
+    EXPECT_EQ(first.use_count(), 2);
+
+    // An alias of the same owner is a different value
+    smart_pointer::shared_ptr<int> alias(atomic.load(), &*first);
+    EXPECT_FALSE(atomic.compare_exchange_weak(alias, smart_pointer::shared_ptr<int>()));
+
+    smart_pointer::shared_ptr<int> empty;
+    smart_pointer::atomic_shared_ptr<int> unset;
+    EXPECT_TRUE(unset.compare_exchange_weak(empty, first));
+    EXPECT_EQ(unset.load().get(), first.get());
+}
+
+TEST(testAtomicSharedPtr, testReadersAndWriters) {
+    {
+        smart_pointer::atomic_shared_ptr<Snapshot> config(smart_pointer::make_shared<Snapshot>(0));
+        std::atomic<bool> done = false;
+        std::vector<std::thread> readers;
+        for (int t = 0; t < 4; ++t) {
+            readers.emplace_back([&config, &done] {
+                int last = 0;
+                while (!done) {
+                    auto snapshot = config.load();
+                    // Versions only grow, and a loaded snapshot stays valid while it is held
+                    EXPECT_GE(snapshot->version, last);
+                    last = snapshot->version;
+                }
+            });
+        }
+        std::thread incrementer([&config] {
+            for (int i = 0; i < 2000; ++i) {
+                auto expected = config.load();
+                while (!config.compare_exchange_weak(expected,
+                                                     smart_pointer::make_shared<Snapshot>(expected->version + 1))) {}
+            }
+        });
+        for (int i = 0; i < 2000; ++i) {
+            auto expected = config.load();
+            while (!config.compare_exchange_strong(expected,
+                                                   smart_pointer::make_shared<Snapshot>(expected->version + 1))) {}
+        }
+        incrementer.join();
+        done = true;
+        for (auto &reader: readers) {
+            reader.join();
+        }
+        EXPECT_EQ(config.load()->version, 4000);
+    }
+    EXPECT_EQ(Snapshot::live, 0);
+}
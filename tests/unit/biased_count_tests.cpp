@@ -0,0 +1,119 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "biased_count.h"
+#include "gtest/gtest.h"
+
+namespace {
+    struct Tracked {
+        static inline std::atomic<long> alive = 0;
+
+        int value = 0;
+
+        explicit Tracked(int value = 0) : value(value) {
+            ++alive;
+        }
+
+        ~Tracked() {
+            --alive;
+        }
+    };
+
+    using Ptr = smart_pointer::biased_shared_ptr<Tracked>;
+
+    Ptr make(int value = 0) {
+        return smart_pointer::make_shared<Tracked, smart_pointer::biased_count>(value);
+    }
+}  // namespace
+
+TEST(testBiasedCount, testOwnerThread) {
+    auto sp = make(1);
+    {
+        std::vector<Ptr> copies(10, sp);
+        EXPECT_EQ(sp.use_count(), 11);
+    }
+    EXPECT_EQ(sp.use_count(), 1);
+    smart_pointer::weak_ptr<Tracked, smart_pointer::biased_count> wp = sp;
+    EXPECT_EQ(wp.lock()->value, 1);
+    sp.reset();
+    EXPECT_EQ(Tracked::alive, 0);
+    EXPECT_TRUE(wp.expired());
+}
+
+TEST(testBiasedCount, testSharedWithOtherThreads) {
+    auto sp = make(2);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([sp] {
+            for (int i = 0; i < 1000; ++i) {
+                Ptr copy = sp;
+                EXPECT_EQ(copy->value, 2);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(sp.use_count(), 1);
+    sp.reset();
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(testBiasedCount, testLastOwnerOnAnotherThread) {
+    auto sp = make();
+    Ptr copy = sp;
+    std::thread([moved = std::move(copy)]() mutable { moved.reset(); }).join();
+    EXPECT_EQ(sp.use_count(), 1);
+    // The owner's last reference goes here: it merges with the release done on the other thread
+    sp.reset();
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(testBiasedCount, testQueuedToOwner) {
+    auto sp = make();
+    std::thread([moved = std::move(sp)]() mutable { moved.reset(); }).join();
+    // The owner's only reference was released elsewhere: the object waits for the owner to merge
+    EXPECT_EQ(Tracked::alive, 1);
+    smart_pointer::biased_count::merge_pending();
+    EXPECT_EQ(Tracked::alive, 0);
+
+    sp = make();
+    std::thread([moved = std::move(sp)]() mutable { moved.reset(); }).join();
+    // Creating an object is a safe point too
+    auto other = make();
+    EXPECT_EQ(Tracked::alive, 1);
+}
+
+TEST(testBiasedCount, testOwnerExited) {
+    Ptr escaped;
+    std::thread([&escaped] { escaped = make(3); }).join();
+    EXPECT_EQ(escaped->value, 3);
+    Ptr copy = escaped;
+    EXPECT_EQ(escaped.use_count(), 2);
+    copy.reset();
+    escaped.reset();
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(testBiasedCount, testWeakLockFromOtherThreads) {
+    auto sp = make(4);
+    smart_pointer::weak_ptr<Tracked, smart_pointer::biased_count> wp = sp;
+    std::atomic<bool> stop = false;
+    std::thread locker([&] {
+        while (!stop) {
+            if (auto locked = wp.lock()) {
+                EXPECT_EQ(locked->value, 4);
+            }
+        }
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    sp.reset();
+    stop = true;
+    locker.join();
+    smart_pointer::biased_count::merge_pending();
+    EXPECT_EQ(Tracked::alive, 0);
+    EXPECT_TRUE(wp.expired());
+}
@@ -0,0 +1,103 @@
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "borrowed_ptr.h"
+#include "fixtures.h"
+
+namespace {
+    using fixtures::Animal;
+    using fixtures::Dog;
+
+    // Walks down a call chain passing the view by value, as the functions it replaces shared_ptr in would
+    int count_legs(smart_pointer::borrowed_ptr<Animal> animal, int depth) {
+        return depth == 0 ? animal->legs() : count_legs(animal, depth - 1);
+    }
+}  // namespace
+
+TEST(testBorrowedPtr, testNoCountTraffic) {
+    EXPECT_EQ(sizeof(smart_pointer::borrowed_ptr<Animal>), 2 * sizeof(void *));
+    // A temporary would be destroyed before the view is used
+    EXPECT_FALSE((std::is_constructible_v<smart_pointer::borrowed_ptr<Animal>, smart_pointer::shared_ptr<Dog>>));
+#ifdef NDEBUG
+    EXPECT_TRUE(std::is_trivially_copyable_v<smart_pointer::borrowed_ptr<Animal>>);
+#endif
+
+    auto dog = smart_pointer::make_shared<Dog>();
+    smart_pointer::borrowed_ptr<Dog> view = dog;
+    auto copy = view;
+    EXPECT_EQ(dog.use_count(), 1);
+    EXPECT_EQ(view.get(), dog.get());
+    EXPECT_EQ(copy->legs(), 4);
+    EXPECT_EQ(count_legs(dog, 100), 4);
+    EXPECT_EQ(dog.use_count(), 1);
+}
+
+TEST(testBorrowedPtr, testToShared) {
+    smart_pointer::shared_ptr<Animal> kept;
+    {
+        auto dog = smart_pointer::make_shared<Dog>();
+        smart_pointer::borrowed_ptr<Animal> view = dog;
+        kept = view.to_shared();
+        EXPECT_EQ(dog.use_count(), 2);
+        EXPECT_EQ(kept.get(), view.get());
+    }
+    EXPECT_EQ(Animal::live, 1);
+    EXPECT_EQ(kept.use_count(), 1);
+    EXPECT_EQ(kept->legs(), 4);
+    kept.reset();
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testBorrowedPtr, testDerivedToBase) {
+    auto dog = smart_pointer::make_shared<Dog>();
+    smart_pointer::borrowed_ptr<Dog> view = dog;
+    smart_pointer::borrowed_ptr<Animal> base = view;
+    EXPECT_EQ(base.get(), static_cast<Animal *>(dog.get()));
+    EXPECT_EQ((*base).legs(), 4);
+
+    smart_pointer::shared_ptr<Animal> owner = base.to_shared();
+    EXPECT_EQ(owner.use_count(), 2);
+    EXPECT_EQ(owner.get(), base.get());
+}
+
+TEST(testBorrowedPtr, testEmptyAndReset) {
+    smart_pointer::borrowed_ptr<Animal> empty;
+    EXPECT_FALSE(empty);
+    EXPECT_EQ(empty.get(), nullptr);
+    EXPECT_FALSE(empty.to_shared());
+
+    smart_pointer::shared_ptr<Animal> none;
+    smart_pointer::borrowed_ptr<Animal> from_empty = none;
+    EXPECT_FALSE(from_empty);
+
+    auto dog = smart_pointer::make_shared<Dog>();
+    smart_pointer::borrowed_ptr<Animal> view = dog;
+    smart_pointer::borrowed_ptr<Animal> other = nullptr;
+    swap(view, other);
+    EXPECT_FALSE(view);
+    EXPECT_EQ(other.get(), dog.get());
+    smart_pointer::borrowed_ptr<Animal> moved = std::move(other);
+    EXPECT_EQ(moved.get(), dog.get());
+    other = std::move(moved);
+    EXPECT_EQ(other.get(), dog.get());
+    other.reset();
+    EXPECT_FALSE(other);
+    EXPECT_EQ(dog.use_count(), 1);
+}
+
+#ifndef NDEBUG
+TEST(testBorrowedPtr, testOutlivedOwner) {
+    auto dog = smart_pointer::make_shared<Dog>();
+    smart_pointer::borrowed_ptr<Animal> view = dog;
+    auto copy = view;
+    dog.reset();
+    EXPECT_EQ(Animal::live, 0);
+    // The weak references of the views keep the block: the views can tell the object is gone
+    EXPECT_THROW(view.get(), std::logic_error);
+    EXPECT_THROW((void) copy->legs(), std::logic_error);
+    EXPECT_THROW(copy.to_shared(), std::logic_error);
+    EXPECT_TRUE(view);
+}
+#endif
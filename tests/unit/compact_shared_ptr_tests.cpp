@@ -0,0 +1,116 @@
+#include <stdexcept>
+#include <utility>
+
+#include "gtest/gtest.h"
+#include "compact_shared_ptr.h"
+#include "fixtures.h"
+
+namespace {
+    using fixtures::Animal;
+
+    struct Named {
+        const char *name = "Rex";
+    };
+
+    // Animal is the second base: a pointer to it is not the address of the object
+    struct Dog : Named, Animal {
+        int legs() const override {
+            return 4;
+        }
+    };
+}  // namespace
+
+TEST(testCompactSharedPtr, testSizeAndOwnership) {
+    EXPECT_EQ(sizeof(smart_pointer::compact_shared_ptr<Animal>), sizeof(void *));
+    {
+        smart_pointer::compact_shared_ptr<Animal> empty;
+        EXPECT_FALSE(empty);
+        EXPECT_EQ(empty.get(), nullptr);
+        EXPECT_EQ(empty.use_count(), 0);
+
+        auto animal = smart_pointer::make_compact_shared<Animal>();
+        EXPECT_EQ(animal->legs(), 0);
+        EXPECT_EQ(animal.use_count(), 1);
+
+        auto copy = animal;
+        EXPECT_EQ(copy.get(), animal.get());
+        EXPECT_EQ(animal.use_count(), 2);
+
+        auto moved = std::move(copy);
+        EXPECT_FALSE(copy);
+        EXPECT_EQ(animal.use_count(), 2);
+
+        copy = moved;
+        EXPECT_EQ(animal.use_count(), 3);
+        moved.reset();
+        copy = std::move(animal);
+        EXPECT_EQ(copy.use_count(), 1);
+        EXPECT_EQ(Animal::live, 1);
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testCompactSharedPtr, testFullHandle) {
+    {
+        auto full = smart_pointer::make_shared<Animal>();
+        smart_pointer::compact_shared_ptr<Animal> compact(full);
+        EXPECT_EQ(compact.get(), full.get());
+        EXPECT_EQ(full.use_count(), 2);
+
+        smart_pointer::shared_ptr<Animal> back = compact;
+        EXPECT_EQ(back.get(), full.get());
+        EXPECT_EQ(full.use_count(), 3);
+
+        smart_pointer::shared_ptr<Animal> taken = std::move(compact);
+        EXPECT_FALSE(compact);
+        EXPECT_EQ(full.use_count(), 3);
+
+        smart_pointer::compact_shared_ptr<Animal> stolen(std::move(taken));
+        EXPECT_FALSE(taken);
+        EXPECT_EQ(stolen.get(), full.get());
+        EXPECT_EQ(full.use_count(), 3);
+
+        EXPECT_FALSE(smart_pointer::compact_shared_ptr<Animal>(smart_pointer::shared_ptr<Animal>()));
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testCompactSharedPtr, testObjectAwayFromBlock) {
+    static Named outside;
+    smart_pointer::shared_ptr<Named> adopted(&outside, [](Named *) {});
+    EXPECT_THROW(smart_pointer::compact_shared_ptr<Named>{adopted}, std::invalid_argument);
+    EXPECT_THROW(smart_pointer::compact_shared_ptr<Named>{std::move(adopted)}, std::invalid_argument);
+    // A failed conversion leaves the source alone
+    EXPECT_EQ(adopted.get(), &outside);
+    EXPECT_EQ(adopted.use_count(), 1);
+}
+
+TEST(testCompactSharedPtr, testDerivedToBase) {
+    {
+        auto dog = smart_pointer::make_compact_shared<Dog>();
+        smart_pointer::compact_shared_ptr<Animal> animal(dog);
+        EXPECT_EQ(animal.get(), static_cast<Animal *>(dog.get()));
+        EXPECT_EQ(animal->legs(), 4);
+        EXPECT_EQ(dog.use_count(), 2);
+
+        smart_pointer::compact_shared_ptr<Animal> moved(std::move(dog));
+        EXPECT_FALSE(dog);
+        EXPECT_EQ(moved.get(), animal.get());
+        EXPECT_EQ(animal.use_count(), 2);
+
+        smart_pointer::shared_ptr<Animal> full = animal;
+        EXPECT_EQ(full->legs(), 4);
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testCompactSharedPtr, testLocalPolicy) {
+    auto number = smart_pointer::make_compact_shared<int, smart_pointer::local_count>(42);
+    auto copy = number;
+    EXPECT_EQ(*copy, 42);
+    *copy = 7;
+    EXPECT_EQ(*number, 7);
+    EXPECT_EQ(number.use_count(), 2);
+    swap(number, copy);
+    EXPECT_TRUE(smart_pointer::is_trivially_relocatable_v<smart_pointer::compact_shared_ptr<int>>);
+}
@@ -0,0 +1,150 @@
+#include <vector>
+
+#include "cyclic_count.h"
+#include "gtest/gtest.h"
+
+namespace {
+    struct Node {
+        static inline long alive = 0;
+
+        std::vector<smart_pointer::cyclic_shared_ptr<Node>> edges;
+        smart_pointer::cyclic_shared_ptr<int> payload;
+
+        Node() {
+            ++alive;
+        }
+
+        ~Node() {
+            --alive;
+        }
+
+        void trace(smart_pointer::cyclic_tracer &visit) const {
+            for (const auto &edge: edges) {
+                visit(edge);
+            }
+            visit(payload);
+        }
+    };
+
+    using Ptr = smart_pointer::cyclic_shared_ptr<Node>;
+
+    Ptr make() {
+        return smart_pointer::make_shared<Node, smart_pointer::cyclic_count>();
+    }
+
+    // A ring of `size` nodes, each pointing to the next
+    Ptr make_ring(int size) {
+        auto first = make();
+        auto last = first;
+        for (int i = 1; i < size; ++i) {
+            auto next = make();
+            last->edges.push_back(next);
+            last = next;
+        }
+        last->edges.push_back(first);
+        return first;
+    }
+}  // namespace
+
+TEST(testCyclicCount, testAcyclicFreedAtZero) {
+    auto sp = make();
+    sp->edges.push_back(make());
+    auto copy = sp;
+    EXPECT_EQ(sp.use_count(), 2);
+    copy.reset();
+    sp.reset();
+    EXPECT_EQ(Node::alive, 0);
+    // The root buffered by the first release is dropped without finding anything
+    EXPECT_EQ(smart_pointer::collect_cycles(), 0);
+    EXPECT_EQ(smart_pointer::cycle_stats().buffered_roots, 0);
+}
+
+TEST(testCyclicCount, testCollectsCycles) {
+    auto self = make();
+    self->edges.push_back(self);
+    smart_pointer::weak_ptr<Node, smart_pointer::cyclic_count> observer = self;
+    self.reset();
+    auto ring = make_ring(5);
+    ring->payload = smart_pointer::make_shared<int, smart_pointer::cyclic_count>(42);
+    ring.reset();
+    EXPECT_EQ(Node::alive, 6);
+    EXPECT_FALSE(observer.expired());
+
+    auto before = smart_pointer::cycle_stats();
+    EXPECT_EQ(smart_pointer::collect_cycles(), 7);
+    EXPECT_EQ(Node::alive, 0);
+    EXPECT_TRUE(observer.expired());
+    EXPECT_FALSE(observer.lock());
+    EXPECT_EQ(smart_pointer::cycle_stats().collected_objects, before.collected_objects + 7);
+}
+
+TEST(testCyclicCount, testLiveCycleKept) {
+    auto parent = make();
+    auto child = make();
+    parent->edges.push_back(child);
+    child->edges.push_back(parent);
+    auto shared = make();
+    parent->edges.push_back(shared);
+
+    child.reset();
+    EXPECT_EQ(smart_pointer::collect_cycles(), 0);
+    EXPECT_EQ(Node::alive, 3);
+    // The counts subtracted while looking for garbage are restored
+    EXPECT_EQ(parent.use_count(), 2);
+    EXPECT_EQ(parent->edges[0].use_count(), 1);
+    EXPECT_EQ(shared.use_count(), 2);
+
+    parent.reset();
+    EXPECT_EQ(smart_pointer::collect_cycles(), 2);
+    EXPECT_EQ(Node::alive, 1);
+    // The garbage released its reference to the live object
+    EXPECT_EQ(shared.use_count(), 1);
+    shared.reset();
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(testCyclicCount, testRingHeldInside) {
+    // a -> b -> c -> d -> a and a -> c, with c held from outside: b is queued for examination when it turns live
+    auto a = make_ring(4);
+    auto b = a->edges[0];
+    auto c = b->edges[0];
+    a->edges.push_back(c);
+    b.reset();
+    a.reset();
+    EXPECT_EQ(smart_pointer::collect_cycles(), 0);
+    EXPECT_EQ(Node::alive, 4);
+    EXPECT_EQ(c.use_count(), 3);
+    EXPECT_EQ(c->edges[0]->edges[0].use_count(), 1);
+
+    c.reset();
+    EXPECT_EQ(smart_pointer::collect_cycles(), 4);
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(testCyclicCount, testBudget) {
+    for (int i = 0; i < 100; ++i) {
+        make_ring(10);
+    }
+    EXPECT_EQ(Node::alive, 1000);
+    auto before = smart_pointer::cycle_stats();
+    EXPECT_GE(before.buffered_roots, 100);
+
+    // Every ring is examined as a whole from its first root, so three rings go over the budget of 25
+    EXPECT_EQ(smart_pointer::collect_cycles(25), 30);
+    EXPECT_EQ(Node::alive, 970);
+    auto after = smart_pointer::cycle_stats();
+    EXPECT_EQ(after.visited_objects, before.visited_objects + 30);
+    EXPECT_LT(after.buffered_roots, before.buffered_roots);
+    while (smart_pointer::cycle_stats().buffered_roots > 0) {
+        EXPECT_LE(smart_pointer::collect_cycles(100), 100);
+    }
+    EXPECT_EQ(Node::alive, 0);
+}
+
+TEST(testCyclicCount, testLongChain) {
+    // Deep enough to overflow the call stack of a recursive collector
+    auto ring = make_ring(200000);
+    ring.reset();
+    EXPECT_EQ(smart_pointer::collect_cycles(), 200000);
+    EXPECT_EQ(Node::alive, 0);
+}
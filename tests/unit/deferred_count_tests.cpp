@@ -0,0 +1,99 @@
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "deferred_count.h"
+#include "gtest/gtest.h"
+
+namespace {
+    struct Tracked {
+        static inline std::atomic<long> alive = 0;
+
+        std::vector<smart_pointer::deferred_shared_ptr<Tracked>> children;
+
+        Tracked() {
+            ++alive;
+        }
+
+        ~Tracked() {
+            --alive;
+        }
+    };
+}  // namespace
+
+TEST(testDeferredCount, testDestroyedOnDrain) {
+    auto sp = smart_pointer::make_shared<Tracked, smart_pointer::deferred_count>();
+    smart_pointer::weak_ptr<Tracked, smart_pointer::deferred_count> wp = sp;
+    auto before = smart_pointer::deferred_stats();
+    sp.reset();
+    EXPECT_EQ(Tracked::alive, 1);
+    EXPECT_TRUE(wp.expired());
+    EXPECT_FALSE(wp.lock());
+    auto queued = smart_pointer::deferred_stats();
+    EXPECT_EQ(queued.queued_blocks, before.queued_blocks + 1);
+    EXPECT_GT(queued.queued_bytes, before.queued_bytes);
+
+    EXPECT_EQ(smart_pointer::drain(), 1);
+    EXPECT_EQ(Tracked::alive, 0);
+    auto after = smart_pointer::deferred_stats();
+    EXPECT_EQ(after.queued_blocks, 0);
+    EXPECT_EQ(after.queued_bytes, 0);
+    EXPECT_EQ(after.reclaimed_blocks, before.reclaimed_blocks + 1);
+    EXPECT_EQ(after.drains, before.drains + 1);
+    EXPECT_EQ(smart_pointer::drain(), 0);
+}
+
+TEST(testDeferredCount, testCascadeInOneDrain) {
+    auto root = smart_pointer::make_shared<Tracked, smart_pointer::deferred_count>();
+    for (int i = 0; i < 10; ++i) {
+        root->children.push_back(smart_pointer::make_shared<Tracked, smart_pointer::deferred_count>());
+        root->children.back()->children.push_back(smart_pointer::make_shared<Tracked, smart_pointer::deferred_count>());
+    }
+    root.reset();
+    EXPECT_EQ(Tracked::alive, 21);
+    // The children are queued while the root is destroyed, and reclaimed by the same call
+    EXPECT_EQ(smart_pointer::drain(), 21);
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(testDeferredCount, testMemoryLimit) {
+    auto limit = smart_pointer::deferred_memory_limit();
+    smart_pointer::set_deferred_memory_limit(1);
+    auto array = smart_pointer::make_shared<Tracked[], smart_pointer::deferred_count>(5);
+    array.reset();
+    // Over the limit: the owner drained the queue itself
+    EXPECT_EQ(Tracked::alive, 0);
+    smart_pointer::set_deferred_memory_limit(limit);
+    EXPECT_EQ(smart_pointer::deferred_stats().queued_bytes, 0);
+}
+
+TEST(testDeferredCount, testReclaimerThread) {
+    smart_pointer::reclaimer_thread reclaimer(std::chrono::microseconds(100));
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            for (int i = 0; i < 1000; ++i) {
+                auto sp = smart_pointer::make_shared<Tracked, smart_pointer::deferred_count>();
+                auto copy = sp;
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (Tracked::alive != 0 && std::chrono::steady_clock::now() < deadline) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(testDeferredCount, testReclaimerDrainsOnExit) {
+    auto sp = smart_pointer::make_shared<Tracked, smart_pointer::deferred_count>();
+    {
+        smart_pointer::reclaimer_thread reclaimer(std::chrono::hours(1));
+        sp.reset();
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
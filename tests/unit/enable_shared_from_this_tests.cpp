@@ -0,0 +1,146 @@
+#include <memory>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "shared_ptr.h"
+
+namespace {
+    // Registers callbacks that keep it alive until they run
+    struct Timer : smart_pointer::enable_shared_from_this<Timer> {
+        static inline int live = 0;
+        int fired = 0;
+
+        Timer() {
+            ++live;
+        }
+
+        Timer(const Timer &other) : enable_shared_from_this(other), fired(other.fired) {
+            ++live;
+        }
+
+        Timer &operator=(const Timer &other) = default;
+
+        virtual ~Timer() {
+            --live;
+        }
+
+        void schedule(std::vector<smart_pointer::shared_ptr<Timer>> &queue) {
+            queue.push_back(shared_from_this());
+        }
+    };
+
+    struct RepeatingTimer : Timer {};
+
+    struct LocalNode : smart_pointer::enable_shared_from_this<LocalNode, smart_pointer::local_count> {};
+}  // namespace
+
+TEST(testEnableSharedFromThis, testMakeShared) {
+    {
+        std::vector<smart_pointer::shared_ptr<Timer>> queue;
+        auto timer = smart_pointer::make_shared<Timer>();
+        timer->schedule(queue);
+        timer->schedule(queue);
+        EXPECT_EQ(timer.use_count(), 3);
+        EXPECT_EQ(queue[0].get(), timer.get());
+
+        timer.reset();
+        EXPECT_EQ(Timer::live, 1);
+        for (auto &callback: queue) {
+            ++callback->fired;
+        }
+        EXPECT_EQ(queue[1]->fired, 2);
+    }
+    EXPECT_EQ(Timer::live, 0);
+}
+
+TEST(testEnableSharedFromThis, testAdoptedPointer) {
+    {
+        smart_pointer::shared_ptr<Timer> timer(new RepeatingTimer);
+        auto self = timer->shared_from_this();
+        EXPECT_EQ(self.get(), timer.get());
+        EXPECT_EQ(timer.use_count(), 2);
+
+        smart_pointer::shared_ptr<Timer> other;
+        other.reset(new Timer);
+        EXPECT_EQ(other->shared_from_this().get(), other.get());
+
+        smart_pointer::shared_ptr<const Timer> constant(new Timer);
+        smart_pointer::shared_ptr<const Timer> constant_self = constant->shared_from_this();
+        EXPECT_EQ(constant_self.get(), constant.get());
+        EXPECT_EQ(constant.use_count(), 2);
+    }
+    EXPECT_EQ(Timer::live, 0);
+}
+
+TEST(testEnableSharedFromThis, testWeakFromThis) {
+    smart_pointer::weak_ptr<Timer> weak;
+    {
+        auto timer = smart_pointer::make_shared<Timer>();
+        weak = timer->weak_from_this();
+        EXPECT_EQ(weak.use_count(), 1);
+        const Timer &constant = *timer;
+        smart_pointer::weak_ptr<const Timer> constant_weak = constant.weak_from_this();
+        EXPECT_EQ(constant_weak.lock().get(), timer.get());
+    }
+    EXPECT_TRUE(weak.expired());
+    EXPECT_EQ(Timer::live, 0);
+}
+
+TEST(testEnableSharedFromThis, testNotOwned) {
+    {
+        Timer timer;
+        EXPECT_THROW(timer.shared_from_this(), std::bad_weak_ptr);
+        EXPECT_TRUE(timer.weak_from_this().expired());
+
+        // A copy of an owned object is a new object nobody owns yet
+        auto owned = smart_pointer::make_shared<Timer>();
+        Timer copy(*owned);
+        EXPECT_THROW(copy.shared_from_this(), std::bad_weak_ptr);
+        copy = *owned;
+        EXPECT_TRUE(copy.weak_from_this().expired());
+    }
+    EXPECT_EQ(Timer::live, 0);
+}
+
+namespace {
+    // Asks for a shared_ptr to itself while it is being destroyed
+    struct Farewell : smart_pointer::enable_shared_from_this<Farewell> {
+        bool *refused;
+
+        explicit Farewell(bool *refused) : refused(refused) {}
+
+        ~Farewell() {
+            try {
+                auto self = shared_from_this();
+            } catch (const std::bad_weak_ptr &) {
+                *refused = true;
+            }
+        }
+    };
+}  // namespace
+
+TEST(testEnableSharedFromThis, testFromDestructor) {
+    bool refused = false;
+    auto farewell = smart_pointer::make_shared<Farewell>(&refused);
+    smart_pointer::weak_ptr<Farewell> weak = farewell;
+    farewell.reset();
+    // The last owner is gone: the object is not revived and destroyed a second time
+    EXPECT_TRUE(refused);
+    EXPECT_TRUE(weak.expired());
+
+    refused = false;
+    farewell = smart_pointer::make_shared<Farewell>(&refused);
+    farewell.reset();
+    EXPECT_TRUE(refused);
+}
+
+TEST(testEnableSharedFromThis, testLocalPolicy) {
+    auto node = smart_pointer::make_shared<LocalNode, smart_pointer::local_count>();
+    smart_pointer::local_shared_ptr<LocalNode> self = node->shared_from_this();
+    EXPECT_EQ(node.use_count(), 2);
+    EXPECT_FALSE(node->weak_from_this().expired());
+
+    // An object deriving from enable_shared_from_this with another policy is not hooked up
+    auto timer = smart_pointer::make_shared<Timer, smart_pointer::local_count>();
+    EXPECT_THROW(timer->shared_from_this(), std::bad_weak_ptr);
+}
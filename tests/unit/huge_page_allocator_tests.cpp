@@ -0,0 +1,51 @@
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "huge_page_allocator.h"
+
+namespace {
+    constexpr std::size_t huge_page = std::size_t(2) << 20;
+}  // namespace
+
+TEST(testHugePageAllocator, testBigRequestsAreAligned) {
+    smart_pointer::huge_page_allocator<double> alloc;
+    std::size_t count = 3 * huge_page / sizeof(double);
+    double *buffer = alloc.allocate(count);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(buffer) % huge_page, 0);
+    buffer[0] = 1;
+    buffer[count - 1] = 2;
+    EXPECT_EQ(buffer[0] + buffer[count - 1], 3);
+    alloc.deallocate(buffer, count);
+}
+
+TEST(testHugePageAllocator, testSmallRequestsUseTheHeap) {
+    smart_pointer::huge_page_allocator<int> alloc;
+    int *small = alloc.allocate(4);
+    small[3] = 1;
+    EXPECT_EQ(small[3], 1);
+    alloc.deallocate(small, 4);
+}
+
+TEST(testHugePageAllocator, testMakeHugeShared) {
+    std::size_t count = huge_page / sizeof(double) * 2;
+    auto zeros = smart_pointer::make_huge_shared<double[]>(smart_pointer::numa_placement::first_touch(), count);
+    EXPECT_EQ(zeros[count - 1], 0);
+    auto filled = smart_pointer::make_huge_shared<double[]>(smart_pointer::numa_placement::interleaved(), count, 1.5);
+    EXPECT_EQ(filled[count - 1], 1.5);
+    auto bound = smart_pointer::make_huge_shared_for_overwrite<double[]>(smart_pointer::numa_placement::on_node(0),
+                                                                         count);
+    bound[count - 1] = 2;
+    EXPECT_EQ(bound[count - 1], 2);
+    // Small objects work too, from the heap
+    auto scalar = smart_pointer::make_huge_shared<int>(smart_pointer::numa_placement::interleaved(), 7);
+    EXPECT_EQ(*scalar, 7);
+}
+
+TEST(testHugePageAllocator, testMissingNodeFallsBack) {
+    char probe[16];
+    EXPECT_FALSE(smart_pointer::numa_placement::on_node(-1).apply(probe, sizeof(probe)));
+    // Memory is still handed out, placed by first touch
+    std::size_t count = huge_page / sizeof(double);
+    auto buffer = smart_pointer::make_huge_shared<double[]>(smart_pointer::numa_placement::on_node(63), count, 3.0);
+    EXPECT_EQ(buffer[count - 1], 3.0);
+}
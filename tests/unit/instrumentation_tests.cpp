@@ -0,0 +1,149 @@
+#include <sstream>
+#include <string>
+#include <thread>
+
+#include "shared_ptr.h"
+#include "gtest/gtest.h"
+
+// Built with MP_CPP_HW1_INSTRUMENT defined, in a test program of its own
+
+namespace {
+    namespace instrumentation = smart_pointer::instrumentation;
+
+    // The classes of exe/main.cpp
+    class Animal {
+    public:
+        Animal() = default;
+
+        virtual ~Animal() = default;
+
+        virtual std::string speak() = 0;
+    };
+
+    class Dog : public Animal {
+    public:
+        std::string speak() override {
+            return "Woof!";
+        }
+    };
+
+    class Cat : public Animal {
+    public:
+        std::string speak() override {
+            return "Meow!";
+        }
+    };
+
+    using PtrToAnimal = smart_pointer::shared_ptr<Animal>;
+
+    struct Counted {
+        int value = 0;
+    };
+
+    instrumentation::type_counters counters_of(std::string_view type) {
+        auto snapshot = instrumentation::take_snapshot();
+        auto counters = snapshot.find(type);
+        return counters ? *counters : instrumentation::type_counters{};
+    }
+}  // namespace
+
+TEST(testInstrumentation, testMainWorkload) {
+    // The session of exe/main.cpp with the input "3 Dog Cat Dog 1 2 3 0"
+    std::istringstream input("Dog Cat Dog 1 2 3 0");
+    std::ostringstream output;
+    {
+        auto zoo = smart_pointer::make_shared<PtrToAnimal[]>(3, PtrToAnimal());
+        for (std::size_t i = 0; i < zoo.size(); ++i) {
+            std::string type;
+            input >> type;
+            if (type == "Dog") {
+                zoo[i].reset(new Dog());
+            } else {
+                zoo[i].reset(new Cat());
+            }
+        }
+        std::size_t index = 0;
+        while (input >> index && index != 0) {
+            output << zoo[index - 1]->speak();
+        }
+        EXPECT_EQ(output.str(), "Woof!Meow!Woof!");
+
+        // reset() takes an Animal *, so the blocks of the dogs and the cat are counted under Animal
+        auto animals = counters_of(instrumentation::type_name<Animal>());
+        EXPECT_EQ(animals.allocations, 3);
+        EXPECT_EQ(animals.live_blocks, 3);
+        EXPECT_GT(animals.live_bytes, 0);
+        // reset() adopts the pointer in place, and the empty pattern of the zoo is copied without a block
+        EXPECT_EQ(animals.moves, 0);
+        EXPECT_EQ(animals.copies, 0);
+        EXPECT_EQ(instrumentation::take_snapshot().find(instrumentation::type_name<Dog>()), nullptr);
+
+        auto zoos = counters_of(instrumentation::type_name<PtrToAnimal[]>());
+        EXPECT_EQ(zoos.allocations, 1);
+        EXPECT_EQ(zoos.live_blocks, 1);
+        EXPECT_GE(zoos.live_bytes, static_cast<std::int64_t>(3 * sizeof(PtrToAnimal)));
+    }
+    auto animals = counters_of(instrumentation::type_name<Animal>());
+    EXPECT_EQ(animals.live_blocks, 0);
+    EXPECT_EQ(animals.live_bytes, 0);
+    EXPECT_EQ(counters_of(instrumentation::type_name<PtrToAnimal[]>()).live_bytes, 0);
+}
+
+TEST(testInstrumentation, testCopiesAndMoves) {
+    auto before = counters_of(instrumentation::type_name<Counted>());
+    auto sp = smart_pointer::make_shared<Counted>();
+    {
+        auto first = sp;
+        auto second = sp;
+        auto third = std::move(second);
+        smart_pointer::shared_ptr<Counted> fourth;
+        fourth = first;
+    }
+    auto after = counters_of(instrumentation::type_name<Counted>());
+    EXPECT_EQ(after.allocations - before.allocations, 1);
+    EXPECT_EQ(after.copies - before.copies, 3);
+    EXPECT_EQ(after.moves - before.moves, 1);
+    EXPECT_GE(after.peak_use_count, 4);
+}
+
+TEST(testInstrumentation, testThreadShards) {
+    struct Local {};
+    smart_pointer::shared_ptr<Local> escaped;
+    std::thread([&escaped] {
+        for (int i = 0; i < 10; ++i) {
+            escaped = smart_pointer::make_shared<Local>();
+        }
+    }).join();
+    // The thread has exited: its counts live on in the retired shard
+    auto counters = counters_of(instrumentation::type_name<Local>());
+    EXPECT_EQ(counters.allocations, 10);
+    EXPECT_EQ(counters.live_blocks, 1);
+    escaped.reset();
+    EXPECT_EQ(counters_of(instrumentation::type_name<Local>()).live_blocks, 0);
+}
+
+TEST(testInstrumentation, testCallSitesAndJson) {
+    struct Sited {
+        int value;
+    };
+    std::uint32_t line = __LINE__ + 1;
+    auto sp = smart_pointer::make_shared<Sited>(smart_pointer::call_site(), 7);
+    EXPECT_EQ(sp->value, 7);
+
+    auto snapshot = instrumentation::take_snapshot();
+    bool found = false;
+    for (const auto &site: snapshot.call_sites) {
+        if (site.line == line && site.file.find("instrumentation_tests.cpp") != std::string::npos) {
+            found = true;
+            EXPECT_EQ(site.allocations, 1);
+            EXPECT_GT(site.bytes, sizeof(Sited));
+        }
+    }
+    EXPECT_TRUE(found);
+
+    std::string json = snapshot.to_json();
+    EXPECT_EQ(json.rfind("{\"types\": [", 0), 0);
+    EXPECT_NE(json.find("\"call_sites\": [{\"file\": "), std::string::npos);
+    EXPECT_NE(json.find("\"line\": " + std::to_string(line)), std::string::npos);
+    EXPECT_EQ(json.back(), '}');
+}
@@ -0,0 +1,108 @@
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "intrusive_ptr.h"
+
+namespace {
+    struct Animal : smart_pointer::ref_counted<Animal> {
+        static inline int live = 0;
+
+        Animal() {
+            ++live;
+        }
+
+        Animal(const Animal &other) : ref_counted(other) {
+            ++live;
+        }
+
+        virtual ~Animal() {
+            --live;
+        }
+
+        virtual int legs() const {
+            return 0;
+        }
+
+        // An object can hand out pointers to itself
+        smart_pointer::intrusive_ptr<Animal> self() {
+            return smart_pointer::intrusive_ptr<Animal>(this);
+        }
+    };
+
+    struct Dog : Animal {
+        int legs() const override {
+            return 4;
+        }
+    };
+
+    struct Counter : smart_pointer::ref_counted<Counter, smart_pointer::local_count> {
+        int value = 0;
+    };
+}  // namespace
+
+TEST(testIntrusivePtr, testSizeOfHandle) {
+    EXPECT_EQ(sizeof(smart_pointer::intrusive_ptr<Animal>), sizeof(Animal *));
+}
+
+TEST(testIntrusivePtr, testOwnership) {
+    {
+        smart_pointer::intrusive_ptr<Animal> empty;
+        EXPECT_EQ(empty.get(), nullptr);
+        EXPECT_EQ(empty.use_count(), 0);
+
+        auto dog = smart_pointer::make_intrusive<Dog>();
+        EXPECT_EQ(dog.use_count(), 1);
+        smart_pointer::intrusive_ptr<Animal> animal(dog);
+        EXPECT_EQ(animal->legs(), 4);
+        EXPECT_EQ(dog.use_count(), 2);
+        auto self = animal->self();
+        EXPECT_EQ(self.get(), dog.get());
+        EXPECT_EQ(dog.use_count(), 3);
+
+        auto back = smart_pointer::dynamic_pointer_cast<Dog>(self);
+        EXPECT_EQ(back.get(), dog.get());
+        EXPECT_EQ(smart_pointer::dynamic_pointer_cast<Dog>(smart_pointer::make_intrusive<Animal>()).get(), nullptr);
+
+        animal = animal;
+        EXPECT_EQ(dog.use_count(), 4);
+        self = std::move(animal);
+        EXPECT_EQ(animal.get(), nullptr);
+        EXPECT_EQ(dog.use_count(), 3);
+        dog.reset();
+        back.reset();
+        EXPECT_EQ(Animal::live, 1);
+        self.reset(new Animal(*self));
+        EXPECT_EQ(self.use_count(), 1);
+        EXPECT_EQ(Animal::live, 1);
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testIntrusivePtr, testLocalCount) {
+    auto counter = smart_pointer::make_intrusive<Counter>();
+    auto copy = counter;
+    copy->value = 3;
+    EXPECT_EQ(counter->value, 3);
+    EXPECT_EQ(counter.use_count(), 2);
+}
+
+TEST(testIntrusivePtr, testConcurrentCopies) {
+    {
+        auto shared = smart_pointer::make_intrusive<Dog>();
+        std::vector<std::thread> threads;
+        for (int t = 0; t < 4; ++t) {
+            threads.emplace_back([shared] {
+                for (int i = 0; i < 10000; ++i) {
+                    smart_pointer::intrusive_ptr<Animal> copy(shared);
+                    EXPECT_EQ(copy->legs(), 4);
+                }
+            });
+        }
+        for (auto &thread: threads) {
+            thread.join();
+        }
+        EXPECT_EQ(shared.use_count(), 1);
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
@@ -0,0 +1,86 @@
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <system_error>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "mapped_array.h"
+
+namespace {
+    // A file of 10000 consecutive int32 values, removed at the end of the test
+    class NumbersFile {
+    public:
+        static constexpr std::int32_t count = 10000;
+
+        NumbersFile() : path_(std::filesystem::temp_directory_path() / "mapped_array_tests.bin") {
+            std::vector<std::int32_t> numbers(count);
+            for (std::int32_t i = 0; i < count; ++i) {
+                numbers[i] = i;
+            }
+            std::ofstream(path_, std::ios::binary).write(reinterpret_cast<const char *>(numbers.data()),
+                                                         count * sizeof(std::int32_t));
+        }
+
+        ~NumbersFile() {
+            std::filesystem::remove(path_);
+        }
+
+        [[nodiscard]] const std::filesystem::path &path() const {
+            return path_;
+        }
+
+    private:
+        std::filesystem::path path_;
+    };
+}  // namespace
+
+TEST(testMappedArray, testWholeFile) {
+    NumbersFile file;
+    auto mapped = smart_pointer::map_shared<const std::int32_t[]>(file.path());
+    ASSERT_EQ(mapped.size, NumbersFile::count);
+    EXPECT_EQ(mapped.data[0], 0);
+    EXPECT_EQ(mapped.data[NumbersFile::count - 1], NumbersFile::count - 1);
+    EXPECT_EQ(mapped.data.use_count(), 1);
+    // The deleter knows the length of the mapping, so the shared_ptr does too
+    EXPECT_EQ(mapped.data.size(), NumbersFile::count);
+    EXPECT_EQ(mapped.data.as_span().back(), NumbersFile::count - 1);
+}
+
+TEST(testMappedArray, testOffsetAndCount) {
+    NumbersFile file;
+    // Not at a page boundary
+    auto mapped = smart_pointer::map_shared<const std::int32_t[]>(file.path(), 1234 * sizeof(std::int32_t), 100,
+                                                                   smart_pointer::map_advice::random);
+    ASSERT_EQ(mapped.size, 100);
+    EXPECT_EQ(mapped.data[0], 1234);
+    EXPECT_EQ(mapped.data[99], 1333);
+    EXPECT_EQ(mapped.data.end() - mapped.data.begin(), 100);
+    // The copies outlive the result
+    smart_pointer::shared_ptr<const std::int32_t[]> copy = mapped.data;
+    mapped = {};
+    EXPECT_EQ(copy[50], 1284);
+}
+
+TEST(testMappedArray, testCopyOnWrite) {
+    NumbersFile file;
+    auto writable = smart_pointer::map_shared<std::int32_t[]>(file.path());
+    writable.data[10] = -1;
+    EXPECT_EQ(writable.data[10], -1);
+    auto fresh = smart_pointer::map_shared<const std::int32_t[]>(file.path());
+    EXPECT_EQ(fresh.data[10], 10);
+}
+
+TEST(testMappedArray, testErrors) {
+    NumbersFile file;
+    EXPECT_THROW(smart_pointer::map_shared<const std::int32_t[]>(file.path().string() + ".missing"),
+                 std::system_error);
+    EXPECT_THROW(smart_pointer::map_shared<const std::int32_t[]>(file.path(), 0, NumbersFile::count + 1),
+                 std::out_of_range);
+    EXPECT_THROW(smart_pointer::map_shared<const std::int32_t[]>(file.path(), 2), std::invalid_argument);
+    auto end = NumbersFile::count * sizeof(std::int32_t);
+    auto empty = smart_pointer::map_shared<const std::int32_t[]>(file.path(), end);
+    EXPECT_EQ(empty.size, 0);
+    EXPECT_FALSE(empty.data);
+}
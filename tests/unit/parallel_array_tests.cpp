@@ -0,0 +1,80 @@
+#include <atomic>
+#include <execution>
+#include <stdexcept>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "parallel_array.h"
+
+namespace {
+    // Counts the live instances and throws from the copy constructor once `copies_left` runs out
+    struct Tracked {
+        static inline std::atomic<long> alive = 0;
+        static inline std::atomic<long> copies_left = -1;
+
+        int value = 0;
+
+        Tracked() {
+            ++alive;
+        }
+
+        Tracked(const Tracked &other) : value(other.value) {
+            if (copies_left.fetch_sub(1) == 0) {
+                throw std::runtime_error("copy failed");
+            }
+            ++alive;
+        }
+
+        ~Tracked() {
+            --alive;
+        }
+    };
+
+    constexpr std::size_t big = std::size_t(1) << 20;
+}  // namespace
+
+TEST(testParallelArray, testConstructAndDestroy) {
+    auto shared = smart_pointer::make_shared<int>(5);
+    {
+        using PtrToInt = smart_pointer::shared_ptr<int>;
+        auto array = smart_pointer::make_shared<PtrToInt[]>(std::execution::par, big, shared);
+        ASSERT_EQ(array.size(), big);
+        EXPECT_EQ(shared.use_count(), big + 1);
+        EXPECT_EQ(*array[0], 5);
+        EXPECT_EQ(array[big - 1].get(), shared.get());
+    }
+    EXPECT_EQ(shared.use_count(), 1);
+
+    auto strings = smart_pointer::make_shared<std::string[]>(std::execution::par_unseq, big);
+    EXPECT_TRUE(strings[big / 2].empty());
+    auto rows = smart_pointer::make_shared<int[][4]>(std::execution::par, big / 4, {1, 2, 3, 4});
+    EXPECT_EQ(rows[big / 4 - 1][3], 4);
+    EXPECT_EQ(rows.size(), big / 4);
+}
+
+TEST(testParallelArray, testSequentialPolicy) {
+    auto small = smart_pointer::make_shared<Tracked[]>(std::execution::seq, 10);
+    EXPECT_EQ(Tracked::alive, 10);
+    small.reset();
+    auto values = smart_pointer::make_shared<int[]>(std::execution::unseq, 100, 7);
+    EXPECT_EQ(values[99], 7);
+    EXPECT_EQ(Tracked::alive, 0);
+}
+
+TEST(testParallelArray, testConstructionThrows) {
+    Tracked pattern;
+    Tracked::copies_left = big / 2;
+    EXPECT_THROW(smart_pointer::make_shared<Tracked[]>(std::execution::par, big, pattern), std::runtime_error);
+    Tracked::copies_left = -1;
+    // Only the pattern is left
+    EXPECT_EQ(Tracked::alive, 1);
+}
+
+TEST(testParallelArray, testAllocateShared) {
+    std::allocator<Tracked> alloc;
+    {
+        auto array = smart_pointer::allocate_shared<Tracked[]>(std::execution::par, alloc, big);
+        EXPECT_EQ(Tracked::alive, big);
+    }
+    EXPECT_EQ(Tracked::alive, 0);
+}
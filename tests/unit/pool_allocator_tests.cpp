@@ -0,0 +1,106 @@
+#include <thread>
+#include <vector>
+
+#include "gtest/gtest.h"
+#include "fixtures.h"
+#include "pool_allocator.h"
+
+namespace {
+    using fixtures::Animal;
+    using fixtures::Dog;
+
+    // Allocates a chunk from the pool when its thread exits and reports where it got it
+    struct exit_allocation {
+        int **chunk = nullptr;
+
+        ~exit_allocation() {
+            smart_pointer::pool_allocator<int> alloc;
+            *chunk = alloc.allocate(1);
+            **chunk = 42;
+            alloc.deallocate(*chunk, 1);
+        }
+    };
+
+    // Called before the thread first allocates, it makes the allocation at exit run after the heap of the thread is
+    // handed over: thread_local objects are destroyed in the reverse order of their construction
+    void allocate_at_exit(int **chunk) {
+        thread_local exit_allocation at_exit;
+        at_exit.chunk = chunk;
+    }
+}  // namespace
+
+TEST(testPoolAllocator, testReusesFreedChunks) {
+    smart_pointer::pool_allocator<int> alloc;
+    int *first = alloc.allocate(1);
+    alloc.deallocate(first, 1);
+    int *second = alloc.allocate(1);
+    EXPECT_EQ(first, second);
+    alloc.deallocate(second, 1);
+}
+
+TEST(testPoolAllocator, testBigRequestsBypassThePool) {
+    smart_pointer::pool_allocator<double> alloc;
+    double *big = alloc.allocate(1000);
+    big[999] = 1;
+    EXPECT_EQ(big[999], 1);
+    alloc.deallocate(big, 1000);
+}
+
+TEST(testPoolAllocator, testMakePooledShared) {
+    auto sp = smart_pointer::make_pooled_shared<int>(5);
+    EXPECT_EQ(*sp, 5);
+    auto dog = smart_pointer::make_pooled_shared<Dog>();
+    EXPECT_EQ(dog->legs(), 4);
+    auto arr = smart_pointer::make_pooled_shared<int[]>(4, 7);
+    EXPECT_EQ(arr[3], 7);
+    smart_pointer::shared_ptr<Animal> adopted(new Dog, std::default_delete<Dog>(),
+                                              smart_pointer::pool_allocator<Dog>());
+    EXPECT_EQ(adopted->legs(), 4);
+}
+
+TEST(testPoolAllocator, testCrossThreadFree) {
+    std::vector<smart_pointer::shared_ptr<int>> pointers;
+    std::thread producer([&pointers] {
+        for (int i = 0; i < 10000; ++i) {
+            pointers.push_back(smart_pointer::make_pooled_shared<int>(i));
+        }
+    });
+    producer.join();
+    // The producer's heap is abandoned now; its chunks come back through the remote lists
+    for (int i = 0; i < 10000; ++i) {
+        EXPECT_EQ(*pointers[i], i);
+    }
+    pointers.clear();
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t) {
+        threads.emplace_back([] {
+            std::vector<smart_pointer::shared_ptr<int>> own;
+            for (int i = 0; i < 10000; ++i) {
+                own.push_back(smart_pointer::make_pooled_shared<int>(i));
+            }
+            for (int i = 0; i < 10000; ++i) {
+                EXPECT_EQ(*own[i], i);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+}
+
+TEST(testPoolAllocator, testAllocateFromThreadLocalDestructor) {
+    int *late = nullptr;
+    int *freed = nullptr;
+    std::thread exiting([&] {
+        allocate_at_exit(&late);
+        smart_pointer::pool_allocator<int> alloc;
+        freed = alloc.allocate(1);
+        alloc.deallocate(freed, 1);
+    });
+    exiting.join();
+    // Taking the handed over heap back would have popped the chunk freed last from its free list, and kept the heap
+    // from the next thread for good
+    EXPECT_NE(late, nullptr);
+    EXPECT_NE(late, freed);
+}
@@ -0,0 +1,108 @@
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "shared_value.h"
+
+namespace {
+    struct Point {
+        std::int32_t x;
+        std::int32_t y;
+    };
+
+    // As big as a value the handle of a shared_ptr's size can hold, and just too big
+    using Triple = std::array<std::int32_t, 3>;
+    using Pair = std::array<std::int64_t, 2>;
+
+    using Big = std::array<std::int64_t, 8>;
+}  // namespace
+
+TEST(testSharedValue, testStorageChoice) {
+    EXPECT_TRUE(smart_pointer::shared_value<int>::stored_inline);
+    EXPECT_TRUE(smart_pointer::shared_value<Point>::stored_inline);
+    EXPECT_TRUE(smart_pointer::shared_value<double>::stored_inline);
+    EXPECT_TRUE(smart_pointer::shared_value<Triple>::stored_inline);
+    EXPECT_FALSE(smart_pointer::shared_value<Pair>::stored_inline);
+    EXPECT_FALSE(smart_pointer::shared_value<Big>::stored_inline);
+    EXPECT_FALSE((smart_pointer::shared_value<Big, sizeof(Big)>::stored_inline));
+    EXPECT_TRUE((smart_pointer::shared_value<Big, sizeof(std::optional<Big>)>::stored_inline));
+    // Not trivially copyable: copies would run code, so the value is shared whatever its size
+    EXPECT_FALSE((smart_pointer::shared_value<std::string, 1024>::stored_inline));
+
+    // By default a handle is never bigger than a shared_ptr
+    EXPECT_LE(sizeof(smart_pointer::shared_value<Point>), sizeof(smart_pointer::shared_ptr<Point>));
+    EXPECT_LE(sizeof(smart_pointer::shared_value<double>), sizeof(smart_pointer::shared_ptr<double>));
+    EXPECT_LE(sizeof(smart_pointer::shared_value<Triple>), sizeof(smart_pointer::shared_ptr<Triple>));
+    EXPECT_LE(sizeof(smart_pointer::shared_value<Pair>), sizeof(smart_pointer::shared_ptr<Pair>));
+    EXPECT_LE(sizeof(smart_pointer::shared_value<Big>), sizeof(smart_pointer::shared_ptr<Big>));
+}
+
+TEST(testSharedValue, testInlineValue) {
+    auto point = smart_pointer::make_shared_value<Point>(1, 2);
+    ASSERT_TRUE(point);
+    EXPECT_EQ(point->x, 1);
+    EXPECT_EQ((*point).y, 2);
+    EXPECT_EQ(point.use_count(), 1);
+
+    auto copy = point;
+    EXPECT_EQ(copy->x, 1);
+    EXPECT_EQ(copy->y, 2);
+    // Every handle has its own copy of the value
+    EXPECT_NE(copy.get(), point.get());
+    EXPECT_EQ(copy.use_count(), 1);
+
+    point.reset();
+    EXPECT_FALSE(point);
+    EXPECT_EQ(point.get(), nullptr);
+    EXPECT_EQ(point.use_count(), 0);
+    EXPECT_EQ(copy->x, 1);
+}
+
+TEST(testSharedValue, testSharedBlock) {
+    auto big = smart_pointer::make_shared_value<Big>(Big{1, 2, 3, 4, 5, 6, 7, 8});
+    EXPECT_EQ(big.use_count(), 1);
+    EXPECT_EQ((*big)[7], 8);
+
+    auto copy = big;
+    EXPECT_EQ(copy.get(), big.get());
+    EXPECT_EQ(big.use_count(), 2);
+
+    auto name = smart_pointer::make_shared_value<std::string, 1024>("a string too long to fit in the handle anyway");
+    auto other = name;
+    EXPECT_EQ(other.get(), name.get());
+    EXPECT_EQ(other->size(), 45);
+
+    copy.reset();
+    EXPECT_EQ(big.use_count(), 1);
+}
+
+TEST(testSharedValue, testLocalPolicy) {
+    auto big = smart_pointer::make_shared_value<Big, sizeof(int), smart_pointer::local_count>();
+    auto copy = big;
+    EXPECT_EQ(big.use_count(), 2);
+    EXPECT_EQ((*copy)[0], 0);
+
+    auto number = smart_pointer::make_shared_value<int, 2 * sizeof(int), smart_pointer::local_count>(7);
+    EXPECT_TRUE(number.stored_inline);
+    EXPECT_EQ(*number, 7);
+}
+
+TEST(testSharedValue, testFromSharedPtrAndSwap) {
+    smart_pointer::shared_ptr<const Point> owner = smart_pointer::make_shared<Point>(Point{3, 4});
+    smart_pointer::shared_value<Point> point(owner);
+    EXPECT_EQ(point->y, 4);
+    EXPECT_EQ(owner.use_count(), 1);
+
+    smart_pointer::shared_ptr<const Big> big_owner = smart_pointer::make_shared<Big>();
+    smart_pointer::shared_value<Big> big(big_owner);
+    EXPECT_EQ(big.get(), big_owner.get());
+    EXPECT_EQ(big_owner.use_count(), 2);
+
+    smart_pointer::shared_value<Point> empty = nullptr;
+    EXPECT_FALSE(smart_pointer::shared_value<Point>(smart_pointer::shared_ptr<const Point>()));
+    swap(point, empty);
+    EXPECT_FALSE(point);
+    EXPECT_EQ(empty->x, 3);
+}
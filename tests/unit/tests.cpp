@@ -1,6 +1,53 @@
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <new>
+#include <span>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
 #include "gtest/gtest.h"
 #include "shared_ptr.h"
 
+// Counts every call to the global operator new so tests can check how many allocations an operation makes
+static std::atomic<std::size_t> allocations = 0;
+
+void *operator new(std::size_t size) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    if (void *ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+// The operators delete are kept out of line: inlined into a caller, their free() looks to GCC like freeing what
+// operator new returned, and -Wmismatched-new-delete fires
+[[gnu::noinline]] void operator delete(void *ptr) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment) {
+    allocations.fetch_add(1, std::memory_order_relaxed);
+    auto align = static_cast<std::size_t>(alignment);
+    if (void *ptr = std::aligned_alloc(align, (size + align - 1) / align * align)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+[[gnu::noinline]] void operator delete(void *ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
 class A {
 public:
     A() = default;
@@ -119,6 +166,38 @@ TEST(testConstructors, testMultidimArrayNullptr) {
     EXPECT_EQ(sp3.use_count(), 0);
 }
 
+// Empty pointers are constant-initialised and need no dynamic initialisation or allocation
+constinit smart_pointer::shared_ptr<int> global_empty;
+constinit smart_pointer::shared_ptr<A[]> global_empty_array(nullptr);
+
+TEST(testConstructors, testConstexprEmpty) {
+    constexpr smart_pointer::shared_ptr<int> sp;
+    static_assert(sp.get() == nullptr);
+    static_assert(sp.use_count() == 0);
+    static_assert(!smart_pointer::shared_ptr<double[][3]>(nullptr).use_count());
+    EXPECT_EQ(global_empty.get(), nullptr);
+    EXPECT_EQ(global_empty_array.use_count(), 0);
+}
+
+TEST(testConstructors, testEmptyDoesNotAllocate) {
+    std::size_t before = allocations;
+    {
+        smart_pointer::shared_ptr<int> sp;
+        smart_pointer::shared_ptr<int> sp2(nullptr);
+        smart_pointer::shared_ptr<int> copy(sp);
+        copy = sp2;
+        smart_pointer::shared_ptr<int> moved(std::move(copy));
+        moved.reset();
+        sp.reset();
+    }
+    EXPECT_EQ(allocations - before, 0);
+
+    using PtrToA = smart_pointer::shared_ptr<A>;
+    before = allocations;
+    auto sp_arr = smart_pointer::make_shared<PtrToA[]>(1000, PtrToA());
+    EXPECT_EQ(allocations - before, 1);
+}
+
 TEST(testConstructors, testSimpleCreation) {
     smart_pointer::shared_ptr<int> sp(new int(5));
     EXPECT_EQ(*sp.get(), 5);
@@ -483,6 +562,609 @@ TEST(testMakeShared, testArrayCompleteTypeDefaultValue) {
     EXPECT_EQ(sp_md_arr[2][2], 3);
 }
 
+TEST(testMakeShared, testSingleAllocation) {
+    std::size_t before = allocations;
+    auto sp = smart_pointer::make_shared<std::size_t>(5);
+    EXPECT_EQ(allocations - before, 1);
+
+    before = allocations;
+    auto sp2 = smart_pointer::make_shared<B>();
+    EXPECT_EQ(allocations - before, 1);
+}
+
+TEST(testMakeShared, testArraySingleAllocation) {
+    std::size_t before = allocations;
+    auto sp_arr = smart_pointer::make_shared<long double[]>(3);
+    EXPECT_EQ(allocations - before, 1);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(sp_arr.get()) % alignof(long double), 0);
+
+    before = allocations;
+    auto sp_md_arr = smart_pointer::make_shared<double[][4]>(3, {1, 2, 3, 4});
+    EXPECT_EQ(allocations - before, 1);
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(sp_md_arr.get()) % alignof(double), 0);
+    EXPECT_EQ(sp_md_arr[2][3], 4);
+}
+
+TEST(testMakeShared, testArrayOfObjects) {
+    using PtrToA = smart_pointer::shared_ptr<A>;
+    PtrToA element(new B);
+    {
+        auto sp_arr = smart_pointer::make_shared<PtrToA[]>(4, element);
+        EXPECT_EQ(element.use_count(), 5);
+        EXPECT_EQ(sp_arr[3]->whoami(), 'B');
+
+        auto sp_fixed = smart_pointer::make_shared<PtrToA[2]>(element);
+        EXPECT_EQ(element.use_count(), 7);
+    }
+    EXPECT_EQ(element.use_count(), 1);
+}
+
+// Throws from its constructor once three instances are alive
+struct Fragile {
+    static inline int alive = 0;
+
+    Fragile() {
+        if (alive == 3) {
+            throw std::runtime_error("fragile");
+        }
+        ++alive;
+    }
+
+    Fragile(const Fragile &) : Fragile() {}
+
+    ~Fragile() {
+        --alive;
+    }
+};
+
+TEST(testMakeShared, testArrayConstructionThrows) {
+    EXPECT_THROW(smart_pointer::make_shared<Fragile[]>(5), std::runtime_error);
+    EXPECT_EQ(Fragile::alive, 0);
+    {
+        Fragile row[2];
+        EXPECT_THROW(smart_pointer::make_shared<Fragile[][2]>(2, row), std::runtime_error);
+        EXPECT_EQ(Fragile::alive, 2);
+    }
+    EXPECT_EQ(Fragile::alive, 0);
+}
+
+TEST(testThreads, testConcurrentCopies) {
+    auto sp = smart_pointer::make_shared<int>(42);
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 8; ++t) {
+        threads.emplace_back([&sp] {
+            for (int i = 0; i < 10000; ++i) {
+                smart_pointer::shared_ptr<int> copy(sp);
+                smart_pointer::shared_ptr<int> other;
+                other = copy;
+                EXPECT_EQ(*other, 42);
+            }
+        });
+    }
+    for (auto &thread: threads) {
+        thread.join();
+    }
+    EXPECT_EQ(sp.use_count(), 1);
+}
+
+// Counts destructions to check that an object shared between threads is destroyed exactly once
+struct Counted {
+    static inline std::atomic<int> destroyed = 0;
+
+    ~Counted() {
+        destroyed.fetch_add(1);
+    }
+};
+
+TEST(testThreads, testLastOwnerOnAnotherThread) {
+    Counted::destroyed = 0;
+    constexpr int objects = 1000;
+    std::vector<smart_pointer::shared_ptr<Counted>> first, second;
+    for (int i = 0; i < objects; ++i) {
+        first.push_back(smart_pointer::make_shared<Counted>());
+        second.push_back(first.back());
+    }
+    std::thread one([owned = std::move(first)]() mutable { owned.clear(); });
+    std::thread two([owned = std::move(second)]() mutable { owned.clear(); });
+    one.join();
+    two.join();
+    EXPECT_EQ(Counted::destroyed.load(), objects);
+}
+
+TEST(testPolicies, testLocalCount) {
+    smart_pointer::local_shared_ptr<A> sp(new B);
+    smart_pointer::local_shared_ptr<A> sp2(sp);
+    EXPECT_EQ(sp.use_count(), 2);
+    EXPECT_EQ(sp2->whoami(), 'B');
+    sp.reset();
+    EXPECT_EQ(sp2.use_count(), 1);
+
+    auto sp_arr = smart_pointer::make_shared<int[], smart_pointer::local_count>(3, 7);
+    EXPECT_EQ(sp_arr[2], 7);
+    static_assert(std::is_same_v<decltype(sp_arr), smart_pointer::local_shared_ptr<int[]>>);
+}
+
+TEST(testWeakPtr, testEmpty) {
+    smart_pointer::weak_ptr<int> wp;
+    EXPECT_TRUE(wp.expired());
+    EXPECT_EQ(wp.use_count(), 0);
+    EXPECT_EQ(wp.lock().get(), nullptr);
+
+    smart_pointer::shared_ptr<int> empty;
+    smart_pointer::weak_ptr<int> wp2(empty);
+    EXPECT_TRUE(wp2.expired());
+}
+
+TEST(testWeakPtr, testLock) {
+    auto sp = smart_pointer::make_shared<int>(5);
+    smart_pointer::weak_ptr<int> wp(sp);
+    EXPECT_FALSE(wp.expired());
+    EXPECT_EQ(wp.use_count(), 1);
+    {
+        auto locked = wp.lock();
+        EXPECT_EQ(locked.get(), sp.get());
+        EXPECT_EQ(*locked, 5);
+        EXPECT_EQ(sp.use_count(), 2);
+    }
+    EXPECT_EQ(sp.use_count(), 1);
+
+    smart_pointer::weak_ptr<int> copy(wp);
+    smart_pointer::weak_ptr<int> moved(std::move(copy));
+    EXPECT_EQ(moved.lock().get(), sp.get());
+    sp.reset();
+    EXPECT_TRUE(wp.expired());
+    EXPECT_TRUE(moved.expired());
+    EXPECT_EQ(wp.lock().get(), nullptr);
+}
+
+TEST(testWeakPtr, testObjectDestroyedBeforeBlock) {
+    Counted::destroyed = 0;
+    smart_pointer::weak_ptr<Counted> wp;
+    {
+        auto sp = smart_pointer::make_shared<Counted>();
+        wp = sp;
+        smart_pointer::weak_ptr<Counted> wp2;
+        wp2 = wp;
+        smart_pointer::shared_ptr<Counted> sp2(new Counted);
+        wp2 = sp2;
+    }
+    EXPECT_EQ(Counted::destroyed.load(), 2);
+    EXPECT_TRUE(wp.expired());
+    wp.reset();
+    EXPECT_EQ(Counted::destroyed.load(), 2);
+}
+
+TEST(testWeakPtr, testArrays) {
+    auto sp_arr = smart_pointer::make_shared<int[][2]>(3, {1, 2});
+    smart_pointer::weak_ptr<int[][2]> wp(sp_arr);
+    EXPECT_EQ(wp.lock()[2][1], 2);
+    sp_arr = smart_pointer::make_shared<int[][2]>(1);
+    EXPECT_TRUE(wp.expired());
+
+    smart_pointer::shared_ptr<int[]> sp(new int[3]{1, 2, 3});
+    smart_pointer::weak_ptr<int[]> wp2 = sp;
+    EXPECT_EQ(wp2.lock()[1], 2);
+}
+
+TEST(testWeakPtr, testLockRacesWithRelease) {
+    for (int round = 0; round < 100; ++round) {
+        Counted::destroyed = 0;
+        auto sp = smart_pointer::make_shared<Counted>();
+        smart_pointer::weak_ptr<Counted> wp(sp);
+        std::thread locker([wp] {
+            while (auto locked = wp.lock()) {
+                EXPECT_EQ(Counted::destroyed.load(), 0);
+            }
+        });
+        sp.reset();
+        locker.join();
+        EXPECT_EQ(Counted::destroyed.load(), 1);
+    }
+}
+
+// Allocator that counts the blocks it currently has allocated
+template<typename T>
+struct TrackingAllocator {
+    using value_type = T;
+
+    int *live;
+
+    explicit TrackingAllocator(int *counter) : live(counter) {}
+
+    template<typename U>
+    TrackingAllocator(const TrackingAllocator<U> &other) : live(other.live) {}
+
+    T *allocate(std::size_t n) {
+        ++*live;
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) {
+        --*live;
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template<typename U>
+    bool operator==(const TrackingAllocator<U> &other) const {
+        return live == other.live;
+    }
+};
+
+TEST(testDeleters, testCustomDeleter) {
+    int deleted = 0;
+    {
+        int value = 5;
+        smart_pointer::shared_ptr<int> sp(&value, [&deleted](int *) { ++deleted; });
+        smart_pointer::shared_ptr<int> sp2(sp);
+        EXPECT_EQ(*sp2, 5);
+        sp.reset();
+        EXPECT_EQ(deleted, 0);
+    }
+    EXPECT_EQ(deleted, 1);
+
+    smart_pointer::shared_ptr<char[]> buffer(static_cast<char *>(std::malloc(16)), std::free);
+    buffer[15] = 'x';
+    EXPECT_EQ(buffer[15], 'x');
+
+    smart_pointer::shared_ptr<A> sp3;
+    sp3.reset(new B, [&deleted](B *ptr) {
+        ++deleted;
+        delete ptr;
+    });
+    EXPECT_EQ(sp3->whoami(), 'B');
+    sp3.reset();
+    EXPECT_EQ(deleted, 2);
+}
+
+TEST(testDeleters, testEmptyDeleterTakesNoSpace) {
+    using default_block = smart_pointer::detail::pointer_control_block<
+            int, std::default_delete<int>, std::allocator<int>, smart_pointer::atomic_count>;
+    EXPECT_EQ(sizeof(default_block), sizeof(void *) + sizeof(smart_pointer::atomic_count::counts) + sizeof(int *));
+}
+
+TEST(testDeleters, testCustomAllocator) {
+    int live = 0;
+    int deleted = 0;
+    {
+        smart_pointer::shared_ptr<int> sp(new int(5), [&deleted](int *ptr) {
+            ++deleted;
+            delete ptr;
+        }, TrackingAllocator<int>(&live));
+        EXPECT_EQ(live, 1);
+        smart_pointer::weak_ptr<int> wp(sp);
+        sp.reset();
+        EXPECT_EQ(deleted, 1);
+        EXPECT_EQ(live, 1);
+    }
+    EXPECT_EQ(live, 0);
+}
+
+TEST(testAllocateShared, testNotArray) {
+    int live = 0;
+    {
+        auto sp = smart_pointer::allocate_shared<std::string>(TrackingAllocator<char>(&live), 3, 'a');
+        EXPECT_EQ(*sp, "aaa");
+        EXPECT_EQ(live, 1);
+        auto sp2 = smart_pointer::allocate_shared<B>(TrackingAllocator<int>(&live));
+        EXPECT_EQ(sp2->whoami(), 'B');
+        EXPECT_EQ(live, 2);
+    }
+    EXPECT_EQ(live, 0);
+}
+
+TEST(testAllocateShared, testArrays) {
+    int live = 0;
+    {
+        TrackingAllocator<int> alloc(&live);
+        auto sp_arr = smart_pointer::allocate_shared<int[]>(alloc, 4);
+        EXPECT_EQ(sp_arr[3], 0);
+        auto sp_md_arr = smart_pointer::allocate_shared<int[][2]>(alloc, 3, {1, 2});
+        EXPECT_EQ(sp_md_arr[2][1], 2);
+        auto sp_fixed = smart_pointer::allocate_shared<std::string[2]>(alloc, "x");
+        EXPECT_EQ(sp_fixed[1], "x");
+        auto sp_fixed_md = smart_pointer::allocate_shared<double[2][2]>(alloc);
+        EXPECT_EQ(sp_fixed_md[1][1], 0);
+        EXPECT_EQ(live, 4);
+    }
+    EXPECT_EQ(live, 0);
+}
+
+TEST(testMakeShared, testBulkFill) {
+    constexpr std::size_t rows = 100000;
+    auto sp_zero = smart_pointer::make_shared<double[]>(rows);
+    auto sp_fill = smart_pointer::make_shared<int[]>(rows, 7);
+    auto sp_bytes = smart_pointer::make_shared<char[]>(rows, 'x');
+    int pattern[3] = {1, 2, 3};
+    auto sp_rows = smart_pointer::make_shared<int[][3]>(rows, pattern);
+    auto sp_fixed_rows = smart_pointer::make_shared<int[5][3]>(pattern);
+    for (std::size_t i = 0; i < rows; ++i) {
+        ASSERT_EQ(sp_zero[i], 0);
+        ASSERT_EQ(sp_fill[i], 7);
+        ASSERT_EQ(sp_bytes[i], 'x');
+        for (std::size_t j = 0; j < 3; ++j) {
+            ASSERT_EQ(sp_rows[i][j], pattern[j]);
+        }
+    }
+    EXPECT_EQ(sp_fixed_rows[4][2], 3);
+    EXPECT_EQ(smart_pointer::make_shared<int[][3]>(0, pattern).get() != nullptr, true);
+}
+
+TEST(testMakeShared, testFillThrows) {
+    {
+        Fragile element;
+        EXPECT_THROW(smart_pointer::make_shared<Fragile[]>(5, element), std::runtime_error);
+        EXPECT_EQ(Fragile::alive, 1);
+    }
+    EXPECT_EQ(Fragile::alive, 0);
+}
+
+TEST(testMakeShared, testForOverwrite) {
+    std::size_t before = allocations;
+    auto sp = smart_pointer::make_shared_for_overwrite<int>();
+    *sp = 5;
+    EXPECT_EQ(*sp, 5);
+    auto sp_arr = smart_pointer::make_shared_for_overwrite<int[]>(1000);
+    auto sp_fixed = smart_pointer::make_shared_for_overwrite<double[4][4]>();
+    EXPECT_EQ(allocations - before, 3);
+    for (int i = 0; i < 1000; ++i) {
+        sp_arr[i] = i;
+    }
+    EXPECT_EQ(sp_arr[999], 999);
+    sp_fixed[3][3] = 1.5;
+    EXPECT_EQ(sp_fixed[3][3], 1.5);
+    // Classes are still default-constructed
+    auto sp_strings = smart_pointer::make_shared_for_overwrite<std::string[]>(3);
+    EXPECT_TRUE(sp_strings[2].empty());
+    EXPECT_THROW(smart_pointer::make_shared_for_overwrite<Fragile[]>(4), std::runtime_error);
+    EXPECT_EQ(Fragile::alive, 0);
+}
+
+// Allocator with its own construct(), which must be used for every element
+template<typename T>
+struct ConstructingAllocator {
+    using value_type = T;
+
+    int *constructed;
+
+    explicit ConstructingAllocator(int *counter) : constructed(counter) {}
+
+    template<typename U>
+    ConstructingAllocator(const ConstructingAllocator<U> &other) : constructed(other.constructed) {}
+
+    T *allocate(std::size_t n) {
+        return std::allocator<T>().allocate(n);
+    }
+
+    void deallocate(T *ptr, std::size_t n) {
+        std::allocator<T>().deallocate(ptr, n);
+    }
+
+    template<typename U, typename... Args>
+    void construct(U *ptr, Args &&... args) {
+        ++*constructed;
+        ::new (static_cast<void *>(ptr)) U(std::forward<Args>(args)...);
+    }
+
+    template<typename U>
+    bool operator==(const ConstructingAllocator<U> &other) const {
+        return constructed == other.constructed;
+    }
+};
+
+TEST(testAllocateShared, testAllocatorConstruct) {
+    int constructed = 0;
+    ConstructingAllocator<int> alloc(&constructed);
+    auto sp_arr = smart_pointer::allocate_shared<int[]>(alloc, 4, 9);
+    EXPECT_EQ(sp_arr[3], 9);
+    int pattern[2] = {1, 2};
+    auto sp_rows = smart_pointer::allocate_shared<int[][2]>(alloc, 3, pattern);
+    EXPECT_EQ(sp_rows[2][1], 2);
+    EXPECT_EQ(constructed, 10);
+}
+
+TEST(testMakeShared, testBatch) {
+    EXPECT_TRUE(smart_pointer::make_shared_batch<B>(0).empty());
+
+    std::size_t before = allocations;
+    auto batch = smart_pointer::make_shared_batch<std::size_t>(4, 7);
+    // The vector of handles and the batch itself
+    EXPECT_EQ(allocations - before, 2);
+    ASSERT_EQ(batch.size(), 4);
+    for (std::size_t i = 0; i < batch.size(); ++i) {
+        EXPECT_EQ(*batch[i], 7);
+        EXPECT_EQ(batch[i].get(), batch[0].get() + i);
+        EXPECT_EQ(batch[i].use_count(), 4);
+    }
+    *batch[1] = 8;
+    EXPECT_EQ(*batch[0], 7);
+
+    std::vector<smart_pointer::shared_ptr<A>> zoo;
+    zoo.push_back(smart_pointer::make_shared_batch<B>(3)[1]);
+    EXPECT_EQ(zoo[0].use_count(), 1);
+    EXPECT_EQ(zoo[0]->whoami(), 'B');
+}
+
+TEST(testMakeShared, testBatchLifetime) {
+    smart_pointer::shared_ptr<Fragile> kept;
+    {
+        auto batch = smart_pointer::make_shared_batch<Fragile>(3);
+        EXPECT_EQ(Fragile::alive, 3);
+        kept = batch[2];
+        smart_pointer::weak_ptr<Fragile> first(batch[0]);
+        batch.clear();
+        // The last handle to any of the objects keeps the whole batch
+        EXPECT_EQ(Fragile::alive, 3);
+        EXPECT_FALSE(first.expired());
+    }
+    kept.reset();
+    EXPECT_EQ(Fragile::alive, 0);
+
+    EXPECT_THROW(smart_pointer::make_shared_batch<Fragile>(5), std::runtime_error);
+    EXPECT_EQ(Fragile::alive, 0);
+
+    // More owners than the 32-bit use count of atomic_count holds: rejected before the 4 GiB are allocated
+    EXPECT_THROW(smart_pointer::make_shared_batch<char>(std::size_t(1) << 32), std::length_error);
+}
+
+TEST(testAllocateShared, testBatch) {
+    int live = 0;
+    int constructed = 0;
+    {
+        auto batch = smart_pointer::allocate_shared_batch<std::string>(TrackingAllocator<char>(&live), 3, 2, 'a');
+        EXPECT_EQ(live, 1);
+        EXPECT_EQ(*batch[2], "aa");
+        auto counted = smart_pointer::allocate_shared_batch<int>(ConstructingAllocator<int>(&constructed), 5, 1);
+        EXPECT_EQ(constructed, 5);
+    }
+    EXPECT_EQ(live, 0);
+}
+
+TEST(testCasts, testConvertingConstructors) {
+    auto sp_b = smart_pointer::make_shared<B>();
+    smart_pointer::shared_ptr<A> sp_a(sp_b);
+    EXPECT_EQ(sp_a.get(), sp_b.get());
+    EXPECT_EQ(sp_a.use_count(), 2);
+    smart_pointer::shared_ptr<A> sp_moved(std::move(sp_b));
+    EXPECT_EQ(sp_b.get(), nullptr);
+    EXPECT_EQ(sp_moved.use_count(), 2);
+    smart_pointer::shared_ptr<const A> sp_const;
+    sp_const = sp_a;
+    EXPECT_EQ(sp_const.get(), sp_a.get());
+    EXPECT_EQ(sp_a.use_count(), 3);
+    auto sp_fixed = smart_pointer::make_shared<int[3]>(7);
+    smart_pointer::shared_ptr<int[]> sp_unbounded(sp_fixed);
+    EXPECT_EQ(sp_unbounded[2], 7);
+}
+
+TEST(testCasts, testAliasing) {
+    struct Pair {
+        int first;
+        std::string second;
+    };
+    std::size_t before = allocations;
+    auto pair = smart_pointer::make_shared<Pair>(1, "two");
+    smart_pointer::shared_ptr<std::string> second(pair, &pair->second);
+    EXPECT_EQ(allocations - before, 1);
+    EXPECT_EQ(pair.use_count(), 2);
+    pair.reset();
+    EXPECT_EQ(*second, "two");
+    EXPECT_EQ(second.use_count(), 1);
+
+    // A view into the middle of a shared buffer keeps the whole buffer alive
+    auto buffer = smart_pointer::make_shared<int[]>(8, 5);
+    smart_pointer::shared_ptr<int[]> view(std::move(buffer), buffer.get() + 4);
+    EXPECT_EQ(buffer.get(), nullptr);
+    EXPECT_EQ(view.use_count(), 1);
+    EXPECT_EQ(view[3], 5);
+}
+
+TEST(testCasts, testPointerCasts) {
+    smart_pointer::shared_ptr<A> sp_a = smart_pointer::make_shared<B>();
+    auto sp_b = smart_pointer::static_pointer_cast<B>(sp_a);
+    EXPECT_EQ(sp_b->whoami(), 'B');
+    EXPECT_EQ(sp_a.use_count(), 2);
+    auto sp_dyn = smart_pointer::dynamic_pointer_cast<B>(sp_a);
+    EXPECT_EQ(sp_dyn.get(), sp_b.get());
+    EXPECT_EQ(sp_a.use_count(), 3);
+
+    smart_pointer::shared_ptr<A> sp_plain = smart_pointer::make_shared<A>();
+    auto sp_fail = smart_pointer::dynamic_pointer_cast<B>(std::move(sp_plain));
+    EXPECT_EQ(sp_fail.get(), nullptr);
+    EXPECT_EQ(sp_fail.use_count(), 0);
+    EXPECT_EQ(sp_plain.use_count(), 1);
+
+    auto sp_const = smart_pointer::const_pointer_cast<const A>(sp_a);
+    auto sp_mutable = smart_pointer::const_pointer_cast<A>(std::move(sp_const));
+    EXPECT_EQ(sp_mutable.get(), sp_a.get());
+    EXPECT_EQ(sp_a.use_count(), 4);
+
+    auto sp_int = smart_pointer::make_shared<int>(0x01020304);
+    auto sp_bytes = smart_pointer::reinterpret_pointer_cast<unsigned char[]>(sp_int);
+    EXPECT_EQ(static_cast<void *>(sp_bytes.get()), static_cast<void *>(sp_int.get()));
+    EXPECT_EQ(sp_int.use_count(), 2);
+}
+
+TEST(testArrayAccess, testSize) {
+    auto sp_arr = smart_pointer::make_shared<int[]>(10);
+    EXPECT_EQ(sp_arr.size(), 10);
+    auto sp_fixed = smart_pointer::make_shared<int[4]>();
+    EXPECT_EQ(sp_fixed.size(), 4);
+    smart_pointer::shared_ptr<int[]> sp_unbounded = sp_fixed;
+    EXPECT_EQ(sp_unbounded.size(), 4);
+    auto sp_rows = smart_pointer::make_shared<int[][3]>(5);
+    EXPECT_EQ(sp_rows.size(), 5);
+    auto sp_overwrite = smart_pointer::make_shared_for_overwrite<double[]>(7);
+    EXPECT_EQ(sp_overwrite.size(), 7);
+
+    // An alias into the array sees the elements from where it points
+    smart_pointer::shared_ptr<int[]> sp_tail(sp_arr, sp_arr.get() + 6);
+    EXPECT_EQ(sp_tail.size(), 4);
+    smart_pointer::shared_ptr<int[][3]> sp_last_rows(sp_rows, sp_rows.get() + 3);
+    EXPECT_EQ(sp_last_rows.size(), 2);
+
+    // The length of adopted arrays is not known, unless the deleter tells it
+    smart_pointer::shared_ptr<int[]> sp_adopted(new int[3]);
+    EXPECT_EQ(sp_adopted.size(), 0);
+    EXPECT_EQ(sp_adopted.begin(), sp_adopted.end());
+    struct SizedDeleter {
+        std::size_t count;
+
+        void operator()(int *ptr) const {
+            delete[] ptr;
+        }
+
+        [[nodiscard]] std::size_t extent() const noexcept {
+            return count;
+        }
+    };
+    smart_pointer::shared_ptr<int[]> sp_sized(new int[6](), SizedDeleter{6});
+    EXPECT_EQ(sp_sized.size(), 6);
+    EXPECT_EQ(sp_sized.end() - sp_sized.begin(), 6);
+    smart_pointer::shared_ptr<int[]> sp_sized_tail(sp_sized, sp_sized.get() + 2);
+    EXPECT_EQ(sp_sized_tail.size(), 4);
+    EXPECT_EQ(smart_pointer::shared_ptr<int[]>().size(), 0);
+    EXPECT_EQ(smart_pointer::shared_ptr<int[2]>().size(), 0);
+}
+
+TEST(testArrayAccess, testIterators) {
+    auto sp_arr = smart_pointer::make_shared<int[]>(5, 1);
+    int sum = 0;
+    for (int value: sp_arr) {
+        sum += value;
+    }
+    EXPECT_EQ(sum, 5);
+    std::ranges::fill(sp_arr, 2);
+    EXPECT_EQ(std::ranges::count(sp_arr, 2), 5);
+    EXPECT_EQ(sp_arr.end() - sp_arr.begin(), 5);
+    smart_pointer::shared_ptr<int[]> sp_empty;
+    EXPECT_EQ(sp_empty.begin(), sp_empty.end());
+}
+
+TEST(testArrayAccess, testSpan) {
+    auto sp_arr = smart_pointer::make_shared<int[]>(6, 3);
+    std::span<int> all = sp_arr.as_span();
+    EXPECT_EQ(all.size(), 6);
+    EXPECT_EQ(all.data(), sp_arr.get());
+    // Split into chunks without copying
+    all.subspan(3)[0] = 4;
+    EXPECT_EQ(sp_arr[3], 4);
+
+    auto sp_fixed = smart_pointer::make_shared<const double[3]>(1.5);
+    std::span<const double, 3> fixed = sp_fixed.as_span();
+    EXPECT_EQ(fixed[2], 1.5);
+    static_assert(decltype(sp_fixed.as_span())::extent == 3);
+}
+
+#ifndef NDEBUG
+TEST(testArrayAccess, testAt) {
+    auto sp_arr = smart_pointer::make_shared<int[]>(3, 7);
+    EXPECT_EQ(sp_arr.at(2), 7);
+    EXPECT_THROW(sp_arr.at(3), std::out_of_range);
+    smart_pointer::shared_ptr<int[]> sp_adopted(new int[3]);
+    EXPECT_THROW(sp_adopted.at(0), std::out_of_range);
+}
+#endif
+
 
 int main(int argc, char **argv) {
     ::testing::InitGoogleTest(&argc, argv);
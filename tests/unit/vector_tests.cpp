@@ -0,0 +1,150 @@
+#include <memory>
+#include <new>
+#include <string>
+
+#include "gtest/gtest.h"
+#include "atomic_shared_ptr.h"
+#include "fixtures.h"
+#include "intrusive_ptr.h"
+#include "shared_value.h"
+#include "vector.h"
+
+namespace {
+    using fixtures::Animal;
+
+    struct Node : smart_pointer::ref_counted<Node> {};
+
+    // Shared pointers 0..count-1 to as many animals
+    smart_pointer::vector<smart_pointer::shared_ptr<Animal>> make_animals(std::size_t count) {
+        smart_pointer::vector<smart_pointer::shared_ptr<Animal>> animals;
+        for (std::size_t i = 0; i < count; ++i) {
+            animals.push_back(smart_pointer::make_shared<Animal>());
+        }
+        return animals;
+    }
+}  // namespace
+
+TEST(testVector, testTriviallyRelocatable) {
+    EXPECT_TRUE(smart_pointer::is_trivially_relocatable_v<smart_pointer::shared_ptr<Animal>>);
+    EXPECT_TRUE(smart_pointer::is_trivially_relocatable_v<smart_pointer::local_shared_ptr<int[]>>);
+    EXPECT_TRUE(smart_pointer::is_trivially_relocatable_v<smart_pointer::weak_ptr<Animal>>);
+    EXPECT_TRUE(smart_pointer::is_trivially_relocatable_v<smart_pointer::intrusive_ptr<Node>>);
+    EXPECT_TRUE(smart_pointer::is_trivially_relocatable_v<smart_pointer::shared_value<std::string>>);
+    EXPECT_TRUE(smart_pointer::is_trivially_relocatable_v<int>);
+    EXPECT_FALSE(smart_pointer::is_trivially_relocatable_v<std::string>);
+    EXPECT_FALSE(smart_pointer::is_trivially_relocatable_v<smart_pointer::atomic_shared_ptr<Animal>>);
+
+    // Relocating by hand: the bytes move, the counts stay as they are
+    {
+        auto animal = smart_pointer::make_shared<Animal>();
+        alignas(smart_pointer::shared_ptr<Animal>) unsigned char from[sizeof(smart_pointer::shared_ptr<Animal>)];
+        alignas(smart_pointer::shared_ptr<Animal>) unsigned char to[sizeof(smart_pointer::shared_ptr<Animal>)];
+        auto *source = new(from) smart_pointer::shared_ptr<Animal>(animal);
+        auto *target = reinterpret_cast<smart_pointer::shared_ptr<Animal> *>(to);
+        smart_pointer::uninitialized_relocate(source, source + 1, target);
+        EXPECT_EQ(target->get(), animal.get());
+        EXPECT_EQ(animal.use_count(), 2);
+        std::destroy_at(target);
+        EXPECT_EQ(animal.use_count(), 1);
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testVector, testGrowth) {
+    {
+        auto animal = smart_pointer::make_shared<Animal>();
+        smart_pointer::vector<smart_pointer::shared_ptr<Animal>> animals;
+        EXPECT_EQ(animals.capacity(), 0);
+        for (int i = 0; i < 1000; ++i) {
+            animals.push_back(animal);
+        }
+        EXPECT_EQ(animals.size(), 1000);
+        EXPECT_GE(animals.capacity(), 1000);
+        EXPECT_EQ(animal.use_count(), 1001);
+        EXPECT_EQ(animals[999].get(), animal.get());
+
+        animals.pop_back();
+        EXPECT_EQ(animal.use_count(), 1000);
+        animals.resize(10);
+        EXPECT_EQ(animal.use_count(), 11);
+        animals.resize(12);
+        EXPECT_FALSE(animals.back());
+        animals.clear();
+        EXPECT_TRUE(animals.empty());
+        EXPECT_EQ(animal.use_count(), 1);
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testVector, testInsertErase) {
+    {
+        auto animals = make_animals(8);
+        smart_pointer::vector<Animal *> order;
+        for (auto &animal: animals) {
+            order.push_back(animal.get());
+        }
+
+        auto extra = smart_pointer::make_shared<Animal>();
+        auto *inserted = animals.insert(animals.begin() + 3, extra);
+        EXPECT_EQ(inserted, animals.begin() + 3);
+        EXPECT_EQ(extra.use_count(), 2);
+        EXPECT_EQ(animals[2].get(), order[2]);
+        EXPECT_EQ(animals[4].get(), order[3]);
+
+        auto *next = animals.erase(animals.begin() + 3);
+        EXPECT_EQ(next->get(), order[3]);
+        EXPECT_EQ(extra.use_count(), 1);
+
+        animals.erase(animals.begin() + 1, animals.begin() + 5);
+        ASSERT_EQ(animals.size(), 4);
+        EXPECT_EQ(animals[0].get(), order[0]);
+        EXPECT_EQ(animals[1].get(), order[5]);
+        EXPECT_EQ(animals[3].get(), order[7]);
+        EXPECT_EQ(Animal::live, 5);
+
+        // The value may be an element of the vector itself, with and without room to spare
+        animals.reserve(animals.size() + 1);
+        animals.insert(animals.begin(), animals.back());
+        EXPECT_EQ(animals[0].get(), order[7]);
+        animals.emplace(animals.begin() + 1, animals[4]);
+        EXPECT_EQ(animals[1].get(), order[7]);
+        EXPECT_EQ(animals[0].use_count(), 3);
+    }
+    EXPECT_EQ(Animal::live, 0);
+}
+
+TEST(testVector, testNotTriviallyRelocatable) {
+    smart_pointer::vector<std::string> words = {"one", "two", "three"};
+    words.insert(words.begin() + 1, "a string long enough to live on the heap");
+    words.insert(words.begin(), words[1]);
+    for (int i = 0; i < 100; ++i) {
+        words.emplace_back(10, 'x');
+    }
+    words.erase(words.begin() + 2, words.begin() + 4);
+    ASSERT_EQ(words.size(), 103);
+    EXPECT_EQ(words[0], "a string long enough to live on the heap");
+    EXPECT_EQ(words[1], "one");
+    EXPECT_EQ(words[2], "three");
+    EXPECT_EQ(words[102], "xxxxxxxxxx");
+}
+
+TEST(testVector, testCopyAndMove) {
+    {
+        auto animals = make_animals(3);
+        auto copy = animals;
+        EXPECT_EQ(animals[0].use_count(), 2);
+        EXPECT_EQ(copy[2].get(), animals[2].get());
+
+        auto moved = std::move(copy);
+        EXPECT_TRUE(copy.empty());
+        EXPECT_EQ(animals[1].use_count(), 2);
+
+        copy = moved;
+        moved = std::move(animals);
+        EXPECT_EQ(copy[0].use_count(), 2);
+        swap(copy, animals);
+        EXPECT_EQ(animals.size(), 3);
+        EXPECT_TRUE(copy.empty());
+    }
+    EXPECT_EQ(Animal::live, 0);
+}